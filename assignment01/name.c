@@ -2,46 +2,401 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>	// 컴파일 시 -pthread 옵션 필요
+#include <unistd.h>		// sysconf
+#include <sys/mman.h>	// mmap
+#include <sys/stat.h>	// fstat
+#include <fcntl.h>		// open
+#include <time.h>		// clock_gettime
+#include <sys/resource.h>	// getrusage
+#include <sys/wait.h>	// waitpid
+#include <stdint.h>		// uintptr_t
+#include <stddef.h>		// offsetof
 
 #define MAX_YEAR_DURATION	10	// 기간
+#define DEFAULT_MAX_RECORD	(1 << 20)	// 외부 정렬 시 메모리에 유지하는 레코드 수
 #define LINEAR_SEARCH 0
 #define BINARY_SEARCH 1
+#define HASH_SEARCH 2
+#define PARALLEL_MERGE 3
+#define COLUMNAR 4
+#define SNAPSHOT 5
+#define EXTERNAL_SORT 6
+#define BENCHMARK 7
+#define NAME_SEGMENT	4096		// 이름 배열을 늘리는 최소 단위 (이름 수)
+#define MAX_NAMES	(1 << 25)	// 이름 배열을 위해 예약하는 주소 공간의 크기 (이름 수)
+#define RECORD_BYTES	12		// 입력 파일의 한 줄 평균 크기 (용량 추정용) ex) "Emma,F,20355\n"
 
 // 구조체 선언
+
+// 이름 문자열 arena의 chunk
+// 큰 chunk를 할당한 후 앞에서부터 잘라 쓰며(bump allocation), 저장한 문자열의 주소는 바뀌지 않음
+#define ARENA_CHUNK	(1 << 16)
+
+typedef struct chunk {
+	struct chunk	*next;	// 먼저 할당된 chunk
+	int		used;			// 사용한 바이트 수
+	int		size;			// data의 크기
+	char	data[];
+} tChunk;
+
+// 이름 문자열 저장소 (string interning)
+// 서로 다른 이름은 arena에 한 번만 저장되고 0부터 차례로 32비트 ID를 부여받음
+// 같은 저장소의 이름끼리는 주소(또는 ID)만 비교하여 같은지 판단할 수 있음
+typedef struct {
+	int		len;			// 저장된 이름의 수
+	int		capacity;		// str 배열의 용량
+	const char	**str;		// ID -> 이름 문자열
+	tChunk	*arena;			// 가장 최근에 할당된 chunk
+	int		slot_capacity;	// slot의 수 (2의 거듭제곱)
+	int		*slot;			// 해시 테이블 (ID + 1, 0은 빈 slot)
+} tIntern;
+
 typedef struct {
-	char	name[20];		// 이름
+	const char	*name;		// 이름 (tNames의 intern에 저장된 문자열)
 	char	sex;			// 성별 M or F
 	int		freq[MAX_YEAR_DURATION]; // 연도별 빈도
 } tName;
 
+// 이름 배열은 가능하면 MAX_NAMES개 크기의 주소 공간을 미리 예약(mmap)해 두고 필요한 만큼만 사용 가능하게 바꿈
+// 이 경우 배열이 늘어나도 기존 이름은 복사되거나 이동하지 않으므로 이름을 가리키는 포인터가 계속 유효함
+// 예약할 수 없는 경우 (주소 공간이 작은 환경 등) realloc으로 2배씩 늘림
 typedef struct {
 	int		len;		// 배열에 저장된 이름의 수
 	int		capacity;	// 배열의 용량 (배열에 저장 가능한 이름의 수)
 	tName	*data;		// 이름 배열의 포인터
+	int		reserved;	// 1이면 data는 예약된 주소 공간, 0이면 malloc
+	tIntern	*intern;	// 이름 문자열 저장소
 } tNames;
 
+// (이름, 성별) 해시 인덱스 (open addressing, linear probing)
+// slot에는 names->data의 인덱스 + 1을 저장 (0은 빈 slot)
+typedef struct {
+	int		len;		// 인덱스에 저장된 이름의 수
+	int		capacity;	// slot의 수 (2의 거듭제곱)
+	int		*slot;		// slot 배열의 포인터
+} tIndex;
+
+// 벤치마크를 위한 통계
+typedef struct {
+	long long	comparisons;	// 이름 비교 횟수
+	long long	grows;			// 이름 배열(열)을 늘린 횟수 (realloc 또는 예약된 주소 공간의 mprotect)
+} tStat;
+
+tStat stats;
+
 ////////////////////////////////////////////////////////////////////////////////
 // 함수 원형 선언(declaration)
 
-int lexist_name(tNames *names, char t_name[], char s) {            // 구조체 안에 있는지 비교하는 함수
+tNames *create_names(void);
+void destroy_names(tNames *pnames);
+int reserve_names(tNames *names, int n);
+void grow_names(tNames *names, int n);
+int estimate_names(char **files, int num_file, int scale);
+tIndex *create_index(void);
+void destroy_index(tIndex *pindex);
+
+// 입력 파일 reader
+// 파일 전체를 메모리에 매핑하고 버퍼 안에서 바로 레코드를 찾음 (줄 단위 복사 없음)
+typedef struct {
+	char	*buf;		// 파일 내용
+	size_t	size;		// 파일 크기
+	size_t	pos;		// 다음 레코드의 위치
+	int		mapped;		// 1이면 mmap, 0이면 malloc (파이프 등 mmap할 수 없는 경우)
+} tReader;
+
+// 레코드 뷰 (이름은 reader의 버퍼를 가리키며 '\0'으로 끝나지 않음)
+typedef struct {
+	const char	*name;		// 이름
+	int			name_len;	// 이름의 길이
+	char		sex;		// 성별 M or F
+	int			freq;		// 빈도
+} tView;
+
+// fp의 내용을 reader에 연결
+// return : 성공 1, 실패 0
+int open_reader(FILE *fp, tReader *rd) {
+	struct stat st;
+	int fd = fileno(fp);
+
+	rd->buf = NULL;
+	rd->size = 0;
+	rd->pos = 0;
+	rd->mapped = 0;
+
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		if (st.st_size == 0)
+			return 1;
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			madvise(p, st.st_size, MADV_SEQUENTIAL);
+			rd->buf = (char *)p;
+			rd->size = st.st_size;
+			rd->mapped = 1;
+			return 1;
+		}
+	}
+
+	// mmap할 수 없는 경우 전체를 읽어 들임
+	size_t capacity = 1 << 16;
+	size_t n;
+	rd->buf = (char *)malloc(capacity);
+	while (rd->buf && (n = fread(rd->buf + rd->size, 1, capacity - rd->size, fp)) > 0) {
+		rd->size += n;
+		if (rd->size == capacity) {
+			capacity = capacity * 2;
+			rd->buf = realloc(rd->buf, capacity);
+		}
+	}
+	return rd->buf != NULL;
+}
+
+// reader에 연결된 메모리를 해제
+void close_reader(tReader *rd) {
+	if (rd->mapped)
+		munmap(rd->buf, rd->size);
+	else
+		free(rd->buf);
+	rd->buf = NULL;
+	rd->size = 0;
+}
+
+// 다음 레코드 "이름,성별,빈도"를 view에 저장
+// 구분자는 memchr(SIMD로 구현되어 있음)로 찾음
+// 형식에 맞지 않는 줄(빈 줄 등)은 건너뜀
+// return : 레코드가 있으면 1, 파일의 끝이면 0
+int next_record(tReader *rd, tView *view) {
+	const char *end = rd->buf + rd->size;
+
+	while (rd->pos < rd->size) {
+		const char *p = rd->buf + rd->pos;
+		const char *eol = (const char *)memchr(p, '\n', end - p);
+		if (eol == NULL) eol = end;
+		rd->pos = eol - rd->buf + 1;
+
+		const char *c1 = (const char *)memchr(p, ',', eol - p);
+		if (c1 == NULL || c1 + 2 >= eol || c1[2] != ',')
+			continue;
+
+		view->name = p;
+		view->name_len = (int)(c1 - p);
+		view->sex = c1[1];
+
+		int freq = 0;
+		for (const char *q = c1 + 3; q < eol && *q >= '0' && *q <= '9'; q++)
+			freq = freq * 10 + (*q - '0');
+		view->freq = freq;
+
+		return 1;
+	}
+	return 0;
+}
+
+// 길이가 주어진 두 이름의 비교 ('\0'으로 끝나는 문자열의 strcmp와 같은 순서)
+int name_compare(const char *name1, int len1, const char *name2, int len2) {
+	int ret = memcmp(name1, name2, len1 < len2 ? len1 : len2);
+
+	if (ret != 0)
+		return ret;
+	return len1 - len2;
+}
+
+// 출력 버퍼
+// 필드마다 printf를 호출하는 대신 버퍼에 직접 변환하여 모은 후 큰 단위로 write
+#define OUT_BUF_SIZE	(1 << 16)
+
+typedef struct {
+	int		fd;					// 출력 파일 기술자
+	int		len;				// 버퍼에 모인 바이트 수
+	char	buf[OUT_BUF_SIZE];
+} tOut;
+
+// 버퍼의 내용을 모두 기록
+void out_flush(tOut *out) {
+	int done = 0;
+	while (done < out->len) {
+		ssize_t n = write(out->fd, out->buf + done, out->len - done);
+		if (n <= 0)
+			break;
+		done += n;
+	}
+	out->len = 0;
+}
+
+// 출력 버퍼를 초기화
+// 표준 입출력(stdio)으로 이미 출력한 내용이 먼저 나가도록 비움
+void out_init(tOut *out, int fd) {
+	fflush(stdout);
+	out->fd = fd;
+	out->len = 0;
+}
+
+// 문자열을 버퍼에 추가
+void out_str(tOut *out, const char *str) {
+	while (*str) {
+		if (out->len == OUT_BUF_SIZE)
+			out_flush(out);
+		out->buf[out->len++] = *str++;
+	}
+}
+
+// 문자 하나를 버퍼에 추가
+void out_char(tOut *out, char ch) {
+	if (out->len == OUT_BUF_SIZE)
+		out_flush(out);
+	out->buf[out->len++] = ch;
+}
+
+// 정수를 10진수로 변환하여 버퍼에 추가
+void out_int(tOut *out, int value) {
+	char tmp[12];
+	int n = 0;
+	unsigned int v = value < 0 ? -(unsigned int)value : (unsigned int)value;
+
+	if (out->len + (int)sizeof(tmp) > OUT_BUF_SIZE)
+		out_flush(out);
+	if (value < 0)
+		out->buf[out->len++] = '-';
+	do {
+		tmp[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v);
+	while (n > 0)
+		out->buf[out->len++] = tmp[--n];
+}
+
+// 길이가 len인 문자열의 해시 값 (FNV-1a)
+unsigned int hash_str(const char *str, int len) {
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < len; i++) {
+		h ^= (unsigned char)str[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// 이름 문자열 저장소를 초기화
+tIntern *create_intern(void) {
+	tIntern *in = (tIntern *)malloc(sizeof(tIntern));
+
+	in->len = 0;
+	in->capacity = 1024;
+	in->str = (const char **)malloc(in->capacity * sizeof(const char *));
+	in->arena = NULL;
+	in->slot_capacity = 2048;
+	in->slot = (int *)calloc(in->slot_capacity, sizeof(int));
+
+	return in;
+}
+
+// 이름 문자열 저장소에 할당된 메모리를 해제 (arena는 chunk 단위로 해제)
+void destroy_intern(tIntern *in) {
+	while (in->arena) {
+		tChunk *next = in->arena->next;
+		free(in->arena);
+		in->arena = next;
+	}
+	free(in->str);
+	free(in->slot);
+	free(in);
+}
+
+// arena에서 size 바이트를 잘라 줌 (현재 chunk가 부족하면 새 chunk 할당)
+static char *arena_alloc(tIntern *in, int size) {
+	if (in->arena == NULL || in->arena->used + size > in->arena->size) {
+		int chunk_size = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+		tChunk *c = (tChunk *)malloc(sizeof(tChunk) + chunk_size);
+		c->next = in->arena;
+		c->used = 0;
+		c->size = chunk_size;
+		in->arena = c;
+	}
+	char *p = in->arena->data + in->arena->used;
+	in->arena->used += size;
+	return p;
+}
+
+// ID의 이름 문자열 (저장소가 해제될 때까지 주소가 바뀌지 않음)
+const char *intern_str(const tIntern *in, int id) {
+	return in->str[id];
+}
+
+// slot 수를 2배로 늘리고 저장된 모든 이름으로 해시 테이블을 다시 구성
+static void rehash_intern(tIntern *in) {
+	free(in->slot);
+	in->slot_capacity = in->slot_capacity * 2;
+	in->slot = (int *)calloc(in->slot_capacity, sizeof(int));
+
+	unsigned int mask = in->slot_capacity - 1;
+	for (int id = 0; id < in->len; id++) {
+		const char *str = intern_str(in, id);
+		unsigned int i = hash_str(str, strlen(str)) & mask;
+		while (in->slot[i] != 0)
+			i = (i + 1) & mask;
+		in->slot[i] = id + 1;
+	}
+}
+
+// 길이가 len인 문자열의 ID (처음 등장한 문자열이면 arena에 저장 후 새 ID 부여)
+int intern_name(tIntern *in, const char *str, int len) {
+	unsigned int mask = in->slot_capacity - 1;
+	unsigned int i = hash_str(str, len) & mask;
+
+	while (in->slot[i] != 0) {
+		const char *p = intern_str(in, in->slot[i] - 1);
+		stats.comparisons++;
+		if (strncmp(p, str, len) == 0 && p[len] == '\0')
+			return in->slot[i] - 1;
+		i = (i + 1) & mask;
+	}
+
+	if (in->len == in->capacity) {
+		in->capacity = in->capacity * 2;
+		in->str = realloc(in->str, in->capacity * sizeof(const char *));
+	}
+
+	char *p = arena_alloc(in, len + 1);
+	memcpy(p, str, len);
+	p[len] = '\0';
+
+	int id = in->len++;
+	in->str[id] = p;
+	in->slot[i] = id + 1;
+
+	// load factor를 1/2 이하로 유지
+	if (in->len * 2 > in->slot_capacity)
+		rehash_intern(in);
+
+	return id;
+}
+
+// '\0'으로 끝나는 문자열을 저장소에 저장하고 저장된 문자열을 돌려줌
+const char *intern_cstr(tIntern *in, const char *str) {
+	return intern_str(in, intern_name(in, str, strlen(str)));
+}
+
+// 이름(t_name은 names->intern에 저장된 문자열)이 구조체 안에 있는지 비교하는 함수
+// 저장소의 문자열끼리는 주소만 비교
+// return value: 발견되는 경우 인덱스, 발견되지 않는 경우 -1
+int lexist_name(tNames *names, const char *t_name, char s) {
 	for (int i = 0; i < names->len; i++) {
-		if (strcmp(t_name, names->data[i].name) == 0 && s == names->data[i].sex)
+		stats.comparisons++;
+		if (t_name == names->data[i].name && s == names->data[i].sex)
 			return i;
 	}
-	return 0;
+	return -1;
 }
 
-void update_name(tNames *names, char a[], int t_freq, int year_index, int seq) {
+void update_name(tNames *names, const char *a, int t_freq, int year_index, int seq) {
 	names -> data[seq].freq[year_index] = t_freq;
 }
 
-void insert_name(tNames *names, char a[], char b, int c, int year_index) {
-	if (names->len == names->capacity) {
-		names->capacity = names->capacity * 2;
-		names->data = realloc(names->data, names->capacity * sizeof(tName));
-	}
+// 새 이름을 배열 끝에 추가 (a는 names->intern에 저장된 문자열)
+void insert_name(tNames *names, const char *a, char b, int c, int year_index) {
+	if (names->len == names->capacity)
+		grow_names(names, names->len + 1);
 
-	strcpy(names->data[names->len].name, a);
+	names -> data[names->len].name = a;
 	names -> data[names->len].sex = b;
 	for (int i = 0; i < MAX_YEAR_DURATION; i++)
 		(names->data[names->len].freq)[i] = 0;
@@ -52,10 +407,13 @@ void insert_name(tNames *names, char a[], char b, int c, int year_index) {
 int b_compare(const void* p1, const void* p2) {
 	tName * info1 = (tName*)p1;
 	tName* info2 = (tName*)p2;
+	stats.comparisons++;
 
-	if (strcmp(info1->name, info2->name) == 0) {
+	if (info1->name == info2->name || strcmp(info1->name, info2->name) == 0) {
 		if (info1->sex == info2->sex)
 			return 0;
+		else if (info1->sex > info2->sex)
+			return 1;
 		else
 			return -1;
 	}
@@ -74,63 +432,202 @@ void b_update_name(tNames *names, tName *name,int t_freq, int year_index) {
 // 주의사항: 동일 이름이 남/여 각각 사용될 수 있으므로, 이름과 성별을 구별해야 함
 // 선형탐색(linear search) 버전
 void load_names_lsearch(FILE *fp, int year_index, tNames *names) {
-	char line[30];
-	int i = 0;
-	char name[20];
-	char sex;
-	int tfreq;
-	while (fgets(line, sizeof(line), fp) != NULL) {
+	tReader rd;
+	tView view;
+	const char *name;
+	int seq, num_id;
+	if (!open_reader(fp, &rd))
+		return;
+	while (next_record(&rd, &view)) {
+		num_id = names->intern->len;
+		name = intern_str(names->intern, intern_name(names->intern, view.name, view.name_len));
+
+		// 처음 보는 문자열이면 탐색할 필요 없음
+		seq = names->intern->len == num_id ? lexist_name(names, name, view.sex) : -1;
+		if (seq < 0)
+			insert_name(names, name, view.sex, view.freq, year_index);
+		else
+			update_name(names, name, view.freq, year_index, seq);
+	}
+	close_reader(&rd);
+}
+
+// batch 정렬을 위한 비교 함수 (batch 안의 위치를 정렬, 같은 이름은 위치순)
+static const tName *sort_batch;
+
+static int batch_compare(const void *p1, const void *p2) {
+	int i1 = *(const int *)p1;
+	int i2 = *(const int *)p2;
+	int ret = b_compare(&sort_batch[i1], &sort_batch[i2]);
+
+	return ret != 0 ? ret : i1 - i2;
+}
+
+// 정렬된 이름 배열에 새 이름 m개(batch)를 병합
+// batch만 정렬한 후 (같은 이름이 여러 번 나오면 마지막 빈도만 남김) 뒤에서부터 채우며 병합
+// 비용 O(n + m log m) (n : 이름 배열의 크기)
+void merge_names(tNames *names, tName *batch, int m) {
+	int *order = (int *)malloc(m * sizeof(int));
+	int num = 0;
 
-		char *ptr = strtok(line, ",");
-		strcpy(name, ptr);
+	for (int k = 0; k < m; k++)
+		order[k] = k;
+	sort_batch = batch;
+	qsort(order, m, sizeof(int), batch_compare);
 
-		ptr = strtok(NULL, ",");
-		sex = *ptr;
+	// 중복 제거 (정렬된 순서대로 앞쪽으로 모음)
+	for (int k = 0; k < m; k++) {
+		if (k + 1 < m && b_compare(&batch[order[k]], &batch[order[k + 1]]) == 0)
+			continue;
+		order[num++] = order[k];
+	}
 
-		ptr = strtok(NULL, ",");
-		tfreq = atoi(ptr);
+	if (names->len + num > names->capacity)
+		grow_names(names, names->len + num);
 
-		if (lexist_name(names, name, sex) == 0)
-			insert_name(names, name, sex, tfreq, year_index);
+	int i = names->len - 1;
+	int j = num - 1;
+	int k = names->len + num - 1;
+	while (j >= 0) {
+		if (i >= 0 && b_compare(&names->data[i], &batch[order[j]]) > 0)
+			names->data[k--] = names->data[i--];
 		else
-			update_name(names, name, tfreq, year_index, lexist_name(names, name, sex));
-	}                
+			names->data[k--] = batch[order[j--]];
+	}
+	names->len += num;
+
+	free(order);
 }
 
 // 이진탐색(binary search) 버전
+// 이름 배열은 항상 정렬된 상태로 유지
+// 새로 등장한 이름은 batch에 모았다가 파일을 다 읽은 후 한 번에 병합 (연도마다 전체를 다시 정렬하지 않음)
 void load_names_bsearch(FILE *fp, int year_index, tNames *names) {
-	char line[30];
-	int i = 0;
+	tReader rd;
+	tView view;
 	tName info;
-	int tfreq;
-	int leng = names->len;
-	while (fgets(line, sizeof(line), fp) != NULL) {
+	tName *found;
+	int m = 0, capacity = 1024;
+	if (!open_reader(fp, &rd))
+		return;
+	tName *batch = (tName *)malloc(capacity * sizeof(tName));
+	while (next_record(&rd, &view)) {
+		info.name = intern_str(names->intern, intern_name(names->intern, view.name, view.name_len));
+		info.sex = view.sex;
 
-		char *ptr = strtok(line, ",");
-		strcpy(info.name, ptr);
+		found = bsearch(&info, names->data, names->len, sizeof(tName), b_compare);
+		if (found) {
+			b_update_name(names, found, view.freq, year_index);
+			continue;
+		}
 
-		ptr = strtok(NULL, ",");
-		info.sex = *ptr;
+		if (m == capacity) {
+			capacity = capacity * 2;
+			batch = realloc(batch, capacity * sizeof(tName));
+		}
+		batch[m] = info;
+		memset(batch[m].freq, 0, sizeof(batch[m].freq));
+		batch[m].freq[year_index] = view.freq;
+		m++;
+	}
+	close_reader(&rd);
 
-		ptr = strtok(NULL, ",");
-		tfreq = atoi(ptr);
+	merge_names(names, batch, m);
+	free(batch);
+}
 
-		if (bsearch(&info, names->data, leng, sizeof(tName), b_compare) == NULL)
-			insert_name(names, info.name, info.sex, tfreq, year_index);
-		else
-			b_update_name(names, bsearch(&info, names->data, leng, sizeof(tName), b_compare), tfreq, year_index);
+// (이름, 성별)의 해시 값
+// 이름은 저장소의 문자열이므로 문자열 내용 대신 주소를 해시
+unsigned int hash_name(const char *t_name, char s) {
+	unsigned long long h = ((unsigned long long)(uintptr_t)t_name << 1) | (s == 'M');
+	h *= 0x9E3779B97F4A7C15ULL;
+	return (unsigned int)(h >> 32);
+}
+
+// 인덱스에서 (이름, 성별)을 탐색
+// return value: 발견되는 경우, names->data의 인덱스
+//				발견되지 않는 경우, -1 (*pos에 삽입되어야 할 slot 번호)
+int hfind_name(tIndex *index, tNames *names, const char *t_name, char s, int *pos) {
+	unsigned int mask = index->capacity - 1;
+	unsigned int i = hash_name(t_name, s) & mask;
+	while (index->slot[i] != 0) {
+		tName *p = &names->data[index->slot[i] - 1];
+		stats.comparisons++;
+		if (p->name == t_name && p->sex == s)
+			return index->slot[i] - 1;
+		i = (i + 1) & mask;
+	}
+	*pos = i;
+	return -1;
+}
+
+// slot 수를 2배로 늘리고 names->data의 앞쪽 index->len개 이름으로 인덱스를 다시 구성
+void rehash_names(tIndex *index, tNames *names) {
+	free(index->slot);
+	index->capacity = index->capacity * 2;
+	index->slot = (int *)calloc(index->capacity, sizeof(int));
+
+	unsigned int mask = index->capacity - 1;
+	for (int k = 0; k < index->len; k++) {
+		unsigned int i = hash_name(names->data[k].name, names->data[k].sex) & mask;
+		while (index->slot[i] != 0)
+			i = (i + 1) & mask;
+		index->slot[i] = k + 1;
+	}
+}
+
+// 해시 인덱스(hash index) 버전
+// 이름 하나당 기대 O(1)에 탐색/삽입 (정렬은 모든 파일을 읽은 후 한 번만 수행)
+// 주의사항: 인덱스는 names->data의 순서에 의존하므로 로딩 중에는 정렬하지 않아야 함
+void load_names_hsearch(FILE *fp, int year_index, tNames *names, tIndex *index) {
+	tReader rd;
+	tView view;
+	const char *name;
+	char sex;
+	int tfreq;
+	int seq, pos;
+	if (!open_reader(fp, &rd))
+		return;
+	while (next_record(&rd, &view)) {
+		name = intern_str(names->intern, intern_name(names->intern, view.name, view.name_len));
+		sex = view.sex;
+		tfreq = view.freq;
+
+		seq = hfind_name(index, names, name, sex, &pos);
+		if (seq >= 0) {
+			update_name(names, name, tfreq, year_index, seq);
+			continue;
+		}
+
+		insert_name(names, name, sex, tfreq, year_index);
+		index->slot[pos] = names->len;
+		index->len++;
+
+		// load factor를 1/2 이하로 유지
+		if (index->len * 2 > index->capacity)
+			rehash_names(index, names);
 	}
+	close_reader(&rd);
 }
 
 // 구조체 배열을 화면에 출력
 void print_names(tNames *names, int num_year) {
+	tOut *out = (tOut *)malloc(sizeof(tOut));
+
+	out_init(out, STDOUT_FILENO);
 	for (int i = 0; i < names->len; i++) {
-		printf("%s\t", names->data[i].name);
-		printf("%c\t", names->data[i].sex);
-		for (int j = 0; j < num_year; j++)
-			printf("%d\t", (names->data[i].freq)[j]);
-		printf("\n");
+		out_str(out, names->data[i].name);
+		out_char(out, '\t');
+		out_char(out, names->data[i].sex);
+		out_char(out, '\t');
+		for (int j = 0; j < num_year; j++) {
+			out_int(out, (names->data[i].freq)[j]);
+			out_char(out, '\t');
+		}
+		out_char(out, '\n');
 	}
+	out_flush(out);
+	free(out);
 }
 
 // qsort를 위한 비교 함수
@@ -138,8 +635,9 @@ void print_names(tNames *names, int num_year) {
 int compare(const void *n1, const void *n2) {
 	tName* tname1 = (tName*)n1;
 	tName* tname2 = (tName*)n2;
+	stats.comparisons++;
 
-	if (strcmp(tname1->name, tname2->name) == 0) {
+	if (tname1->name == tname2->name || strcmp(tname1->name, tname2->name) == 0) {
 		if (tname1->sex > tname2->sex)
 			return 1;
 		else
@@ -150,102 +648,1692 @@ int compare(const void *n1, const void *n2) {
 	}
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// 함수 정의 (definition)
+// 연도별 레코드 (이름, 성별, 빈도)
+// 이름은 복사하지 않고 run의 reader 버퍼 안을 가리킴 (길이 제한 없음)
+typedef struct {
+	const char	*name;		// 이름 ('\0'으로 끝나지 않음)
+	int			name_len;	// 이름의 길이
+	char		sex;		// 성별 M or F
+	int			freq;		// 빈도
+} tRecord;
 
-// 이름 구조체를 초기화
-// len를 0으로, capacity를 1로 초기화
-// return : 구조체 포인터
-tNames *create_names(void)
-{
-	tNames *pnames = (tNames *)malloc( sizeof(tNames));
-	
-	pnames->len = 0;
-	pnames->capacity = 1;
-	pnames->data = (tName *)malloc(pnames->capacity * sizeof(tName));
+// 연도 파일 하나를 읽어 만든 정렬된 run
+typedef struct {
+	char	*path;			// 입력 파일 경로
+	FILE	*fp;			// 이미 열린 입력 파일 (NULL이면 path를 열어서 읽음)
+	int		year_index;		// 연도 인덱스
+	int		ok;				// 파일 열기 성공 여부
+	int		len;			// run에 저장된 레코드의 수
+	int		capacity;		// run의 용량
+	tRecord	*data;			// 레코드 배열의 포인터
+	tReader	rd;				// 입력 파일 (병합이 끝날 때까지 열어 둠)
+} tRun;
 
-	return pnames;
+// 작업자 스레드가 공유하는 작업 목록
+typedef struct {
+	tRun	*runs;
+	int		num_run;
+	int		next;			// 다음에 처리할 run 번호
+	pthread_mutex_t	lock;
+} tJobs;
+
+// run 정렬 및 병합을 위한 비교 함수
+// 정렬 기준 : 이름(1순위), 성별(2순위)
+int r_compare(const void *r1, const void *r2) {
+	const tRecord *rec1 = (const tRecord *)r1;
+	const tRecord *rec2 = (const tRecord *)r2;
+	int ret = name_compare(rec1->name, rec1->name_len, rec2->name, rec2->name_len);
+
+	if (ret != 0)
+		return ret;
+	return rec1->sex - rec2->sex;
 }
 
-// 이름 구조체에 할당된 메모리를 해제
-void destroy_names(tNames *pnames)
-{
-	free(pnames->data);
-	pnames->len = 0;
-	pnames->capacity = 0;
+// 연도 파일 하나를 run에 저장한 후 정렬
+// 레코드의 이름이 reader 버퍼를 가리키므로 reader는 닫지 않음
+void load_run(tRun *run) {
+	tView view;
+	FILE *fp = run->fp ? run->fp : fopen(run->path, "r");
 
-	free(pnames);
+	if (!fp || !open_reader(fp, &run->rd)) {
+		run->ok = 0;
+		if (fp && fp != run->fp) fclose(fp);
+		return;
+	}
+	run->ok = 1;
+
+	fprintf( stderr, "Processing [%s]..\n", run->path);
+
+	while (next_record(&run->rd, &view)) {
+		if (run->len == run->capacity) {
+			run->capacity = run->capacity * 2;
+			run->data = realloc(run->data, run->capacity * sizeof(tRecord));
+		}
+		tRecord *rec = &run->data[run->len];
+
+		rec->name = view.name;
+		rec->name_len = view.name_len;
+		rec->sex = view.sex;
+		rec->freq = view.freq;
+
+		run->len++;
+	}
+	if (fp != run->fp)
+		fclose(fp);
+
+	qsort(run->data, run->len, sizeof(tRecord), r_compare);
 }
 
-////////////////////////////////////////////////////////////////////////////////
-int main(int argc, char **argv)
-{
-	tNames *names;
-	int mode;
-	
-	FILE *fp;
-	int num_year = 0;
-	
-	if (argc <= 2)
-	{
-		fprintf( stderr, "Usage: %s mode FILE...\n\n", argv[0]);
-		fprintf( stderr, "mode\n\t-l\n\t\twith linear search\n\t-b\n\t\twith binary search\n");
-		return 1;
+// 작업자 스레드
+// 처리되지 않은 run이 없을 때까지 하나씩 가져와 처리
+void *load_worker(void *arg) {
+	tJobs *jobs = (tJobs *)arg;
+
+	while (1) {
+		pthread_mutex_lock(&jobs->lock);
+		int k = jobs->next++;
+		pthread_mutex_unlock(&jobs->lock);
+
+		if (k >= jobs->num_run)
+			break;
+		load_run(&jobs->runs[k]);
 	}
-	
-	if (strcmp( argv[1], "-l") == 0) mode = LINEAR_SEARCH;
-	else if (strcmp( argv[1], "-b") == 0) mode = BINARY_SEARCH;
-	else {
-		fprintf( stderr, "unknown mode : %s\n", argv[1]);
-		return 1;
+	return NULL;
+}
+
+// heap[i]가 가리키는 run의 현재 레코드
+#define RUN_HEAD(i)	(&runs[heap[i]].data[pos[heap[i]]])
+
+// run 번호의 최소 힙에서 i번째 원소를 아래로 내림
+static void sift_down(tRun *runs, int *pos, int *heap, int n, int i) {
+	while (1) {
+		int min = i;
+		int l = 2 * i + 1;
+		int r = 2 * i + 2;
+
+		if (l < n && r_compare(RUN_HEAD(l), RUN_HEAD(min)) < 0) min = l;
+		if (r < n && r_compare(RUN_HEAD(r), RUN_HEAD(min)) < 0) min = r;
+		if (min == i)
+			break;
+
+		int tmp = heap[i];
+		heap[i] = heap[min];
+		heap[min] = tmp;
+		i = min;
 	}
-	
-	// 이름 구조체 초기화
-	names = create_names();
+}
 
-	// 첫 연도 알아내기 "yob2009.txt" -> 2009
-	int start_year = atoi( &argv[2][strlen(argv[2])-8]);
-	
-	for (int i = 2; i < argc; i++)
-	{
-		num_year++;
-		fp = fopen( argv[i], "r");
-		if( !fp) {
-			fprintf( stderr, "cannot open file : %s\n", argv[i]);
-			return 1;
+// 정렬된 run들을 k-way 병합하여 이름 구조체에 저장
+// 결과는 이름순 (이름이 같은 경우 성별순)으로 정렬되어 있으므로 다시 정렬할 필요 없음
+void merge_runs(tRun *runs, int num_run, tNames *names) {
+	int *pos = (int *)calloc(num_run, sizeof(int));
+	int *heap = (int *)malloc(num_run * sizeof(int));
+	int n = 0;
+
+	for (int k = 0; k < num_run; k++)
+		if (runs[k].len > 0)
+			heap[n++] = k;
+	for (int i = n / 2 - 1; i >= 0; i--)
+		sift_down(runs, pos, heap, n, i);
+
+	while (n > 0) {
+		tRun *run = &runs[heap[0]];
+		tRecord *rec = RUN_HEAD(0);
+		tName *last = names->len > 0 ? &names->data[names->len - 1] : NULL;
+		const char *name = intern_str(names->intern, intern_name(names->intern, rec->name, rec->name_len));
+
+		if (last && last->sex == rec->sex && last->name == name)
+			last->freq[run->year_index] = rec->freq;
+		else
+			insert_name(names, name, rec->sex, rec->freq, run->year_index);
+
+		if (++pos[heap[0]] == run->len)
+			heap[0] = heap[--n];
+		sift_down(runs, pos, heap, n, 0);
+	}
+
+	free(heap);
+	free(pos);
+}
+
+// 병렬 로딩 버전
+// 연도 파일마다 작업자 스레드에서 정렬된 run을 만든 후 k-way 병합
+// fps가 NULL이 아니면 files[k] 대신 이미 열린 fps[k]를 읽음 (연도는 files[k]의 이름에서 구함)
+// return : 성공 1, 열 수 없는 파일이 있는 경우 0
+int load_names_parallel(char **files, FILE **fps, int num_file, int start_year, tNames *names) {
+	tJobs jobs;
+	int num_thread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int ret = 1;
+
+	if (num_thread < 1) num_thread = 1;
+	if (num_thread > num_file) num_thread = num_file;
+
+	jobs.runs = (tRun *)calloc(num_file, sizeof(tRun));
+	jobs.num_run = num_file;
+	jobs.next = 0;
+	pthread_mutex_init(&jobs.lock, NULL);
+
+	for (int k = 0; k < num_file; k++) {
+		jobs.runs[k].path = files[k];
+		jobs.runs[k].fp = fps ? fps[k] : NULL;
+		jobs.runs[k].year_index = atoi( &files[k][strlen(files[k])-8]) - start_year;
+		jobs.runs[k].capacity = 1;
+		jobs.runs[k].data = (tRecord *)malloc(sizeof(tRecord));
+	}
+
+	pthread_t *tid = (pthread_t *)malloc(num_thread * sizeof(pthread_t));
+	for (int t = 0; t < num_thread; t++)
+		pthread_create(&tid[t], NULL, load_worker, &jobs);
+	for (int t = 0; t < num_thread; t++)
+		pthread_join(tid[t], NULL);
+	free(tid);
+
+	for (int k = 0; k < num_file; k++) {
+		if (!jobs.runs[k].ok) {
+			fprintf( stderr, "cannot open file : %s\n", jobs.runs[k].path);
+			ret = 0;
 		}
+	}
+	if (ret)
+		merge_runs(jobs.runs, num_file, names);
 
-		int year = atoi( &argv[i][strlen(argv[i])-8]); // ex) "yob2009.txt" -> 2009
-		
-		fprintf( stderr, "Processing [%s]..\n", argv[i]);
-		
-		if (mode == LINEAR_SEARCH)
-		{
-			// 연도별 입력 파일(이름 정보)을 구조체에 저장
-			// 선형탐색 모드
-			load_names_lsearch( fp, year-start_year, names);
-		
+	for (int k = 0; k < num_file; k++) {
+		if (jobs.runs[k].ok)
+			close_reader(&jobs.runs[k].rd);
+		free(jobs.runs[k].data);
+	}
+	free(jobs.runs);
+	pthread_mutex_destroy(&jobs.lock);
+
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 열 기반(structure of arrays) 이름 테이블
+// 이름 문자열은 tIntern에 한 번만 저장하고, 각 행(이름, 성별)은 이름 ID,
+// 성별 비트, 연도별 빈도 열의 한 칸으로 표현
+// 연도의 범위는 실행 시 입력 파일로부터 결정됨 (MAX_YEAR_DURATION 제한 없음)
+
+typedef struct {
+	int		len;			// 테이블에 저장된 행(이름, 성별)의 수
+	int		capacity;		// 열의 용량
+	int		start_year;		// 첫 연도
+	int		num_year;		// 연도의 수
+	tIntern	*intern;		// 이름 문자열 저장소
+	int		*id;			// 행 -> 이름 ID
+	unsigned long long *sex;	// 성별 비트맵 (M이면 1, F이면 0)
+	int		**freq;			// 연도별 빈도 열 (freq[연도 인덱스][행])
+	int		id_capacity;	// row_of 배열의 용량
+	int		*row_of[2];		// (성별 비트, 이름 ID) -> 행 + 1 (0이면 없음)
+	int		*order;			// 정렬된 행 번호 (len개)
+	void	*map;			// 스냅샷에서 읽은 경우 매핑된 메모리 (아니면 NULL)
+	size_t	map_size;		// 매핑된 메모리의 크기
+} tTable;
+
+#define SEX_BIT(s)			((s) == 'M')
+#define ROW_SEX(t, r)		(((t)->sex[(r) >> 6] >> ((r) & 63)) & 1)
+
+// 이름 테이블을 초기화
+// 연도의 범위는 [start_year, start_year + num_year)
+tTable *create_table(int start_year, int num_year) {
+	tTable *t = (tTable *)malloc(sizeof(tTable));
+
+	t->len = 0;
+	t->capacity = 1024;
+	t->start_year = start_year;
+	t->num_year = num_year;
+	t->intern = create_intern();
+	t->id = (int *)malloc(t->capacity * sizeof(int));
+	t->sex = (unsigned long long *)calloc(t->capacity / 64, sizeof(unsigned long long));
+	t->freq = (int **)malloc(num_year * sizeof(int *));
+	for (int y = 0; y < num_year; y++)
+		t->freq[y] = (int *)calloc(t->capacity, sizeof(int));
+	t->id_capacity = 1024;
+	t->row_of[0] = (int *)calloc(t->id_capacity, sizeof(int));
+	t->row_of[1] = (int *)calloc(t->id_capacity, sizeof(int));
+	t->order = NULL;
+	t->map = NULL;
+	t->map_size = 0;
+
+	return t;
+}
+
+// 이름 테이블에 할당된 메모리를 해제
+void destroy_table(tTable *t) {
+	if (t->map) {
+		munmap(t->map, t->map_size);
+		free(t->freq);
+		free(t->intern->str);
+		free(t->intern);
+		free(t);
+		return;
+	}
+	for (int y = 0; y < t->num_year; y++)
+		free(t->freq[y]);
+	free(t->freq);
+	free(t->id);
+	free(t->sex);
+	free(t->row_of[0]);
+	free(t->row_of[1]);
+	free(t->order);
+	destroy_intern(t->intern);
+	free(t);
+}
+
+// 모든 열의 용량을 2배로 늘림
+static void grow_table(tTable *t) {
+	int old = t->capacity;
+
+	stats.grows++;
+	t->capacity = t->capacity * 2;
+	t->id = realloc(t->id, t->capacity * sizeof(int));
+	t->sex = realloc(t->sex, t->capacity / 64 * sizeof(unsigned long long));
+	memset(t->sex + old / 64, 0, (t->capacity - old) / 64 * sizeof(unsigned long long));
+	for (int y = 0; y < t->num_year; y++) {
+		t->freq[y] = realloc(t->freq[y], t->capacity * sizeof(int));
+		memset(t->freq[y] + old, 0, (t->capacity - old) * sizeof(int));
+	}
+}
+
+// (이름 ID, 성별)의 행 번호 (없으면 새 행을 추가)
+int table_row(tTable *t, int id, char s) {
+	int bit = SEX_BIT(s);
+
+	if (id >= t->id_capacity) {
+		int old = t->id_capacity;
+		while (id >= t->id_capacity)
+			t->id_capacity = t->id_capacity * 2;
+		for (int k = 0; k < 2; k++) {
+			t->row_of[k] = realloc(t->row_of[k], t->id_capacity * sizeof(int));
+			memset(t->row_of[k] + old, 0, (t->id_capacity - old) * sizeof(int));
 		}
-		else // (mode == BINARY_SEARCH)
-		{
-			// 이진탐색 모드
-			load_names_bsearch( fp, year-start_year, names);
-			
-			// 정렬 (이름순 (이름이 같은 경우 성별순))
-			qsort( names->data, names->len, sizeof(tName), compare);
+	}
+	if (t->row_of[bit][id] != 0)
+		return t->row_of[bit][id] - 1;
+
+	if (t->len == t->capacity)
+		grow_table(t);
+
+	int r = t->len++;
+	t->id[r] = id;
+	if (bit)
+		t->sex[r >> 6] |= 1ULL << (r & 63);
+	t->row_of[bit][id] = r + 1;
+
+	return r;
+}
+
+// 열 기반 테이블 버전
+// 이름은 reader의 버퍼에서 바로 intern되므로 이름 길이 제한 없음
+void load_table(FILE *fp, int year_index, tTable *t) {
+	tReader rd;
+	tView view;
+	if (!open_reader(fp, &rd))
+		return;
+	while (next_record(&rd, &view)) {
+		int id = intern_name(t->intern, view.name, view.name_len);
+		int r = table_row(t, id, view.sex);
+		t->freq[year_index][r] = view.freq;
+	}
+	close_reader(&rd);
+}
+
+// 이름 ID 정렬을 위한 비교 함수 (qsort에 문맥을 넘길 수 없으므로 전역 변수 사용)
+static const tIntern *sort_intern;
+
+static int id_compare(const void *p1, const void *p2) {
+	stats.comparisons++;
+	return strcmp(intern_str(sort_intern, *(const int *)p1), intern_str(sort_intern, *(const int *)p2));
+}
+
+// 행을 이름순 (이름이 같은 경우 성별순)으로 정렬하여 t->order에 저장
+// 서로 다른 이름 ID만 qsort한 후, (이름 순위, 성별)을 키로 행 번호를 배치
+// 행 자체(빈도 열)는 움직이지 않음
+void sort_table(tTable *t) {
+	int num_id = t->intern->len;
+	int *ids = (int *)malloc(num_id * sizeof(int));
+
+	for (int i = 0; i < num_id; i++)
+		ids[i] = i;
+	sort_intern = t->intern;
+	qsort(ids, num_id, sizeof(int), id_compare);
+
+	free(t->order);
+	t->order = (int *)malloc(t->len * sizeof(int));
+
+	int n = 0;
+	for (int i = 0; i < num_id; i++) {
+		for (int bit = 0; bit < 2; bit++) {
+			if (ids[i] < t->id_capacity && t->row_of[bit][ids[i]] != 0)
+				t->order[n++] = t->row_of[bit][ids[i]] - 1;
 		}
+	}
+	free(ids);
+}
+
+// 연도별 총 출생 수 (sex가 'M' 또는 'F'이면 해당 성별만, 0이면 전체)
+// 빈도 열을 순차적으로 읽으므로 컴파일러가 벡터화할 수 있음
+long long sum_year(const tTable *t, int year_index, char s) {
+	const int *col = t->freq[year_index];
+	long long sum = 0;
+
+	if (s == 0) {
+		for (int r = 0; r < t->len; r++)
+			sum += col[r];
+		return sum;
+	}
+
+	unsigned long long flip = SEX_BIT(s) ? 0 : ~0ULL;
+	for (int r = 0; r < t->len; r++) {
+		unsigned long long m = (t->sex[r >> 6] ^ flip) >> (r & 63) & 1;
+		sum += col[r] & -(int)m;
+	}
+	return sum;
+}
+
+// 테이블을 정렬 순서대로 화면에 출력
+void print_table(tTable *t) {
+	tOut *out = (tOut *)malloc(sizeof(tOut));
+
+	out_init(out, STDOUT_FILENO);
+	for (int i = 0; i < t->len; i++) {
+		int r = t->order[i];
+		out_str(out, intern_str(t->intern, t->id[r]));
+		out_char(out, '\t');
+		out_char(out, ROW_SEX(t, r) ? 'M' : 'F');
+		out_char(out, '\t');
+		for (int y = 0; y < t->num_year; y++) {
+			out_int(out, t->freq[y][r]);
+			out_char(out, '\t');
+		}
+		out_char(out, '\n');
+	}
+	out_flush(out);
+	free(out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 이름 테이블의 바이너리 스냅샷
+// 정렬이 끝난 테이블을 한 번 기록해 두면, 이후 실행에서는 파싱/정렬 없이 mmap만으로 테이블을 사용
+// 파일 구성 : 헤더, 이름 위치(offset), 문자열 pool, 행 -> 이름 ID, 성별 비트맵, 정렬된 행 번호, 연도별 빈도 열
+// 각 구역은 8바이트 경계에서 시작
+
+#define SNAPSHOT_MAGIC		"YOBSNAP"
+#define SNAPSHOT_VERSION	1
+
+typedef struct {
+	char		magic[8];		// SNAPSHOT_MAGIC
+	int			version;		// SNAPSHOT_VERSION
+	int			len;			// 행의 수
+	int			num_id;			// 이름의 수
+	int			pool_len;		// 문자열 pool의 크기
+	int			start_year;		// 첫 연도
+	int			num_year;		// 연도의 수
+	long long	off_offset;		// 각 구역의 파일 내 위치
+	long long	off_pool;
+	long long	off_id;
+	long long	off_sex;
+	long long	off_order;
+	long long	off_freq;		// 연도별 빈도 열 (num_year * len개, 연도 순으로 연속)
+	long long	size;			// 파일 전체 크기
+} tSnapHeader;
+
+// 다음 8바이트 경계까지 0으로 채움
+// return : 성공 1, 실패 0
+static int pad_section(FILE *fp, long long *pos) {
+	static const char zero[8];
+	int pad = (8 - *pos % 8) % 8;
+
+	*pos += pad;
+	return fwrite(zero, 1, pad, fp) == (size_t)pad;
+}
+
+// 구역 하나를 기록하고 다음 8바이트 경계까지 0으로 채움
+// return : 구역의 파일 내 위치, 실패하면 -1
+static long long write_section(FILE *fp, const void *ptr, size_t size, long long *pos) {
+	long long start = *pos;
+
+	if (fwrite(ptr, 1, size, fp) != size)
+		return -1;
+	*pos += size;
+	if (!pad_section(fp, pos))
+		return -1;
+
+	return start;
+}
+
+// 정렬된 테이블을 스냅샷 파일로 기록
+// 쓰기나 이동(fseek)이 하나라도 실패하면 실패 (헤더는 마지막에 기록하므로 불완전한 파일은 열 수 없음)
+// return : 성공 1, 실패 0
+int write_snapshot(tTable *t, const char *path) {
+	FILE *fp = fopen(path, "wb");
+	tSnapHeader h;
+	long long pos = sizeof(tSnapHeader);
+	int ok = 1;
+
+	if (!fp)
+		return 0;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	h.version = SNAPSHOT_VERSION;
+	h.len = t->len;
+	h.num_id = t->intern->len;
+	h.start_year = t->start_year;
+	h.num_year = t->num_year;
+
+	// arena의 이름들을 ID 순서대로 이어 붙인 pool에서의 위치
+	int *offset = (int *)malloc((h.num_id + 1) * sizeof(int));
+	if (offset == NULL) {
+		fclose(fp);
+		return 0;
+	}
+	for (int id = 0; id < h.num_id; id++) {
+		offset[id] = h.pool_len;
+		h.pool_len += strlen(intern_str(t->intern, id)) + 1;
+	}
+
+	ok = fseek(fp, pos, SEEK_SET) == 0;
+	if (ok) ok = (h.off_offset = write_section(fp, offset, h.num_id * sizeof(int), &pos)) >= 0;
+	free(offset);
+	h.off_pool = pos;
+	for (int id = 0; ok && id < h.num_id; id++) {
+		const char *str = intern_str(t->intern, id);
+		size_t len = strlen(str) + 1;
+		ok = fwrite(str, 1, len, fp) == len;
+	}
+	pos += h.pool_len;
+	if (ok) ok = pad_section(fp, &pos);
+	if (ok) ok = (h.off_id = write_section(fp, t->id, h.len * sizeof(int), &pos)) >= 0;
+	if (ok) ok = (h.off_sex = write_section(fp, t->sex, (h.len + 63) / 64 * sizeof(unsigned long long), &pos)) >= 0;
+	if (ok) ok = (h.off_order = write_section(fp, t->order, h.len * sizeof(int), &pos)) >= 0;
+	h.off_freq = pos;
+	for (int y = 0; ok && y < t->num_year; y++) {
+		ok = fwrite(t->freq[y], sizeof(int), h.len, fp) == (size_t)h.len;
+		pos += h.len * sizeof(int);
+	}
+	h.size = pos;
+
+	if (ok) ok = fseek(fp, 0, SEEK_SET) == 0;
+	if (ok) ok = fwrite(&h, sizeof(h), 1, fp) == 1;
+
+	if (fclose(fp) != 0)
+		ok = 0;
+	return ok;
+}
+
+// 구역 [off, off + size)가 헤더 뒤, 파일 안에 있고 8바이트 경계에서 시작하는지 검사
+static int section_ok(const tSnapHeader *h, long long off, long long size) {
+	return off >= (long long)sizeof(tSnapHeader) && off % 8 == 0 && size >= 0
+		&& off <= h->size && size <= h->size - off;
+}
+
+// 스냅샷 파일의 헤더와 구역, 이름 위치, 행 -> 이름 ID, 정렬된 행 번호가 올바른지 검사
+// 손상된 파일이 매핑 밖을 가리키지 않도록 테이블을 만들기 전에 모두 확인
+// return : 올바르면 1, 아니면 0
+static int check_snapshot(const char *base, long long size) {
+	const tSnapHeader *h = (const tSnapHeader *)base;
+
+	if (memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || h->version != SNAPSHOT_VERSION
+		|| h->size != size || h->len < 0 || h->num_id < 0 || h->pool_len < 0 || h->num_year < 0)
+		return 0;
+	if (!section_ok(h, h->off_offset, (long long)h->num_id * sizeof(int))
+		|| !section_ok(h, h->off_pool, h->pool_len)
+		|| !section_ok(h, h->off_id, (long long)h->len * sizeof(int))
+		|| !section_ok(h, h->off_sex, (h->len + 63LL) / 64 * sizeof(unsigned long long))
+		|| !section_ok(h, h->off_order, (long long)h->len * sizeof(int))
+		|| !section_ok(h, h->off_freq, (long long)h->num_year * h->len * sizeof(int)))
+		return 0;
+
+	// 이름은 pool 안에서 시작하고, pool의 마지막 문자열은 '\0'으로 끝나야 함
+	const int *offset = (const int *)(base + h->off_offset);
+	if (h->num_id > 0 && (h->pool_len == 0 || base[h->off_pool + h->pool_len - 1] != '\0'))
+		return 0;
+	for (int id = 0; id < h->num_id; id++)
+		if (offset[id] < 0 || offset[id] >= h->pool_len)
+			return 0;
+
+	const int *row_id = (const int *)(base + h->off_id);
+	const int *order = (const int *)(base + h->off_order);
+	for (int r = 0; r < h->len; r++)
+		if (row_id[r] < 0 || row_id[r] >= h->num_id || order[r] < 0 || order[r] >= h->len)
+			return 0;
+
+	return 1;
+}
+
+// 스냅샷 파일을 mmap하여 테이블로 사용
+// 테이블의 열들은 매핑된 메모리를 직접 가리키며 읽기 전용 (intern_name, table_row 사용 불가)
+// return : 테이블 포인터, 올바르지 않은 파일이면 NULL
+tTable *open_snapshot(const char *path) {
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(tSnapHeader)) {
+		close(fd);
+		return NULL;
+	}
+
+	char *base = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return NULL;
+
+	const tSnapHeader *h = (const tSnapHeader *)base;
+	if (!check_snapshot(base, st.st_size)) {
+		munmap(base, st.st_size);
+		return NULL;
+	}
+
+	tTable *t = (tTable *)calloc(1, sizeof(tTable));
+	t->map = base;
+	t->map_size = st.st_size;
+	t->len = h->len;
+	t->capacity = h->len;
+	t->start_year = h->start_year;
+	t->num_year = h->num_year;
+
+	// 이름 문자열은 매핑된 pool을 가리킴 (arena 없음)
+	const int *offset = (const int *)(base + h->off_offset);
+	t->intern = (tIntern *)calloc(1, sizeof(tIntern));
+	t->intern->len = h->num_id;
+	t->intern->capacity = h->num_id;
+	t->intern->str = (const char **)malloc(h->num_id * sizeof(const char *));
+	for (int id = 0; id < h->num_id; id++)
+		t->intern->str[id] = base + h->off_pool + offset[id];
+
+	t->id = (int *)(base + h->off_id);
+	t->sex = (unsigned long long *)(base + h->off_sex);
+	t->order = (int *)(base + h->off_order);
+	t->freq = (int **)malloc(t->num_year * sizeof(int *));
+	for (int y = 0; y < t->num_year; y++)
+		t->freq[y] = (int *)(base + h->off_freq) + (long long)y * t->len;
+
+	return t;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 이름 테이블 질의
+// top K YEAR SEX	: 해당 연도/성별의 빈도 상위 K개 이름
+// rise K YEAR SEX	: 전년 대비 빈도가 가장 많이 증가한 K개 이름
+// fall K YEAR SEX	: 전년 대비 빈도가 가장 많이 감소한 K개 이름
+// rank NAME SEX	: 연도별 순위 (같은 빈도는 같은 순위, 빈도 0이면 -)
+// total YEAR [SEX]	: 연도별 총 출생 수
+// 상위 K개 선택은 전체 정렬 대신 크기 K의 최소 힙을 사용 (O(n log K))
+
+#define KEY_FREQ	0	// 빈도
+#define KEY_RISE	1	// 전년 대비 증가량
+#define KEY_FALL	2	// 전년 대비 감소량
+
+// 행 r의 선택 기준 값
+static inline long long row_key(const tTable *t, int y, int r, int kind) {
+	if (kind == KEY_FREQ)
+		return t->freq[y][r];
+	long long d = (long long)t->freq[y][r] - t->freq[y - 1][r];
+	return kind == KEY_RISE ? d : -d;
+}
+
+// 최소 힙의 i번째 원소를 아래로 내림
+static void key_sift_down(int *heap, long long *key, int n, int i) {
+	while (1) {
+		int min = i;
+		int l = 2 * i + 1;
+		int r = 2 * i + 2;
+
+		if (l < n && key[l] < key[min]) min = l;
+		if (r < n && key[r] < key[min]) min = r;
+		if (min == i)
+			break;
+
+		int tmp = heap[i]; heap[i] = heap[min]; heap[min] = tmp;
+		long long tk = key[i]; key[i] = key[min]; key[min] = tk;
+		i = min;
+	}
+}
+
+// 성별이 s인 행 중 기준 값이 큰 k개를 골라 out에 내림차순으로 저장
+// 기준 값이 0 이하인 행은 제외
+// return : 선택된 행의 수
+int select_rows(const tTable *t, int y, char s, int kind, int k, int *out) {
+	long long *key = (long long *)malloc(k * sizeof(long long));
+	unsigned long long bit = SEX_BIT(s);
+	int n = 0;
+
+	for (int r = 0; r < t->len; r++) {
+		if (ROW_SEX(t, r) != bit)
+			continue;
+		long long v = row_key(t, y, r, kind);
+		if (v <= 0)
+			continue;
+		if (n < k) {
+			// 힙에 추가 (위로 올림)
+			int i = n++;
+			while (i > 0 && key[(i - 1) / 2] > v) {
+				out[i] = out[(i - 1) / 2];
+				key[i] = key[(i - 1) / 2];
+				i = (i - 1) / 2;
+			}
+			out[i] = r;
+			key[i] = v;
+		}
+		else if (v > key[0]) {
+			out[0] = r;
+			key[0] = v;
+			key_sift_down(out, key, n, 0);
+		}
+	}
+
+	// 힙 정렬 (최소 힙에서 꺼낸 원소를 뒤에서부터 채우면 내림차순)
+	for (int m = n - 1; m > 0; m--) {
+		int tmp = out[0]; out[0] = out[m]; out[m] = tmp;
+		long long tk = key[0]; key[0] = key[m]; key[m] = tk;
+		key_sift_down(out, key, m, 0);
+	}
+
+	free(key);
+	return n;
+}
+
+// 질의 문맥
+typedef struct {
+	const tTable	*t;
+	int		num[2];			// 성별(F, M)별 행의 수
+	unsigned int	**sorted[2];	// 성별별, 연도별 오름차순 빈도 배열 (순위 계산용)
+} tQuery;
+
+// 부호 없는 정수 배열을 오름차순으로 정렬 (LSD radix sort, 8비트씩 4번)
+static void radix_sort(unsigned int *a, unsigned int *tmp, int n) {
+	for (int shift = 0; shift < 32; shift += 8) {
+		int count[257] = { 0 };
+		for (int i = 0; i < n; i++)
+			count[((a[i] >> shift) & 0xff) + 1]++;
+		for (int b = 0; b < 256; b++)
+			count[b + 1] += count[b];
+		for (int i = 0; i < n; i++)
+			tmp[count[(a[i] >> shift) & 0xff]++] = a[i];
+		memcpy(a, tmp, n * sizeof(unsigned int));
+	}
+}
+
+// 순위 계산을 위해 성별별, 연도별 빈도를 정렬해 둠
+void create_query(tQuery *q, const tTable *t) {
+	unsigned int *tmp = (unsigned int *)malloc((t->len + 1) * sizeof(unsigned int));
+
+	q->t = t;
+	q->num[0] = q->num[1] = 0;
+	for (int r = 0; r < t->len; r++)
+		q->num[ROW_SEX(t, r)]++;
+
+	for (int bit = 0; bit < 2; bit++) {
+		q->sorted[bit] = (unsigned int **)malloc(t->num_year * sizeof(unsigned int *));
+		for (int y = 0; y < t->num_year; y++) {
+			unsigned int *a = (unsigned int *)malloc((q->num[bit] + 1) * sizeof(unsigned int));
+			int n = 0;
+			for (int r = 0; r < t->len; r++)
+				if ((int)ROW_SEX(t, r) == bit)
+					a[n++] = t->freq[y][r];
+			radix_sort(a, tmp, n);
+			q->sorted[bit][y] = a;
+		}
+	}
+	free(tmp);
+}
+
+// 질의 문맥에 할당된 메모리를 해제
+void destroy_query(tQuery *q) {
+	for (int bit = 0; bit < 2; bit++) {
+		for (int y = 0; y < q->t->num_year; y++)
+			free(q->sorted[bit][y]);
+		free(q->sorted[bit]);
+	}
+}
+
+// 연도 y에서 행 r의 순위 (같은 성별 중 빈도가 더 큰 행의 수 + 1)
+// 정렬된 빈도 배열에서 빈도보다 큰 첫 위치를 이진탐색
+int rank_of(const tQuery *q, int y, int r) {
+	int bit = ROW_SEX(q->t, r);
+	const unsigned int *a = q->sorted[bit][y];
+	unsigned int f = q->t->freq[y][r];
+	int first = 0, last = q->num[bit];
+
+	while (first < last) {
+		int mid = (first + last) / 2;
+		if (a[mid] <= f)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	return q->num[bit] - first + 1;
+}
+
+// (이름, 성별)의 행 번호 (정렬된 행 번호에서 이진탐색)
+// return : 행 번호, 없으면 -1
+int find_row(const tTable *t, const char *name, char s) {
+	int bit = SEX_BIT(s);
+	int first = 0, last = t->len - 1;
+
+	while (first <= last) {
+		int mid = (first + last) / 2;
+		int r = t->order[mid];
+		int c = strcmp(name, intern_str(t->intern, t->id[r]));
+		if (c == 0)
+			c = bit - (int)ROW_SEX(t, r);
+		if (c == 0)
+			return r;
+		else if (c > 0)
+			first = mid + 1;
+		else
+			last = mid - 1;
+	}
+	return -1;
+}
+
+// 연도를 연도 인덱스로 변환
+// return : 연도 인덱스, 범위를 벗어나면 -1
+static int year_index_of(const tTable *t, int year) {
+	if (year < t->start_year || year >= t->start_year + t->num_year)
+		return -1;
+	return year - t->start_year;
+}
+
+// 질의 한 줄을 실행하여 결과를 화면에 출력
+void run_query(const tQuery *q, char *line) {
+	const tTable *t = q->t;
+	char cmd[16], name[128];
+	char s = 0;
+	int k, year, y;
+
+	if (sscanf(line, "%15s", cmd) != 1)
+		return;
+
+	if ((strcmp(cmd, "top") == 0 || strcmp(cmd, "rise") == 0 || strcmp(cmd, "fall") == 0)
+		&& sscanf(line, "%*s %d %d %c", &k, &year, &s) == 3) {
+		int kind = cmd[0] == 't' ? KEY_FREQ : cmd[0] == 'r' ? KEY_RISE : KEY_FALL;
+		if (s != 'M' && s != 'F') {
+			printf("invalid sex : %c\n", s);
+			return;
+		}
+		y = year_index_of(t, year);
+		if (y < 0 || (kind != KEY_FREQ && y == 0) || k <= 0) {
+			printf("out of range\n");
+			return;
+		}
+		int *rows = (int *)malloc(k * sizeof(int));
+		int n = select_rows(t, y, s, kind, k, rows);
+		for (int i = 0; i < n; i++) {
+			int r = rows[i];
+			if (kind == KEY_FREQ)
+				printf("%d\t%s\t%d\n", i + 1, intern_str(t->intern, t->id[r]), t->freq[y][r]);
+			else
+				printf("%d\t%s\t%d\t%+d\n", i + 1, intern_str(t->intern, t->id[r]), t->freq[y][r],
+					t->freq[y][r] - t->freq[y - 1][r]);
+		}
+		free(rows);
+	}
+	else if (strcmp(cmd, "rank") == 0 && sscanf(line, "%*s %127s %c", name, &s) == 2) {
+		if (s != 'M' && s != 'F') {
+			printf("invalid sex : %c\n", s);
+			return;
+		}
+		int r = find_row(t, name, s);
+		if (r < 0) {
+			printf("%s not found\n", name);
+			return;
+		}
+		for (y = 0; y < t->num_year; y++) {
+			if (t->freq[y][r] == 0)
+				printf("%d\t-\n", t->start_year + y);
+			else
+				printf("%d\t%d\n", t->start_year + y, rank_of(q, y, r));
+		}
+	}
+	else if (strcmp(cmd, "total") == 0 && sscanf(line, "%*s %d %c", &year, &s) >= 1) {
+		// 성별이 없으면 전체
+		if (s != 0 && s != 'M' && s != 'F') {
+			printf("invalid sex : %c\n", s);
+			return;
+		}
+		y = year_index_of(t, year);
+		if (y < 0) {
+			printf("out of range\n");
+			return;
+		}
+		printf("%lld\n", sum_year(t, y, s));
+	}
+	else
+		printf("unknown query : %s", line);
+}
+
+// 표준 입력에서 질의를 한 줄씩 읽어 실행
+// 각 질의의 실행 시간을 표준 에러로 출력
+void query_loop(const tTable *t) {
+	tQuery q;
+	char line[256];
+	struct timespec t0, t1;
+
+	create_query(&q, t);
+
+	fprintf( stderr, "Query: top K YEAR SEX, rise K YEAR SEX, fall K YEAR SEX, rank NAME SEX, total YEAR [SEX], quit\n> ");
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		if (strncmp(line, "quit", 4) == 0)
+			break;
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		run_query(&q, line);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		fflush(stdout);
+
+		fprintf( stderr, "(%.3f ms)\n> ", (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+	}
+	destroy_query(&q);
+}
+
+// 입력 파일 이름의 최소/최대 연도 ex) "yob2009.txt" -> 2009
+void year_range(char **files, int num_file, int *min_year, int *max_year) {
+	for (int k = 0; k < num_file; k++) {
+		int year = atoi( &files[k][strlen(files[k])-8]);
+		if (k == 0 || year < *min_year) *min_year = year;
+		if (k == 0 || year > *max_year) *max_year = year;
+	}
+}
+
+// 열 기반 테이블 모드
+// 연도의 범위는 입력 파일 이름의 최소/최대 연도로 결정
+// snap_path가 NULL이 아니면 정렬된 테이블을 스냅샷 파일로 기록
+// query가 1이면 테이블을 출력하는 대신 질의를 실행
+// return : 프로그램 종료 코드
+int run_table(char **files, int num_file, const char *snap_path, int query) {
+	int min_year, max_year;
+	year_range(files, num_file, &min_year, &max_year);
+
+	tTable *t = create_table(min_year, max_year - min_year + 1);
+
+	for (int k = 0; k < num_file; k++) {
+		FILE *fp = fopen( files[k], "r");
+		if (!fp) {
+			fprintf( stderr, "cannot open file : %s\n", files[k]);
+			destroy_table(t);
+			return 1;
+		}
+		fprintf( stderr, "Processing [%s]..\n", files[k]);
+
+		int year = atoi( &files[k][strlen(files[k])-8]);
+		load_table( fp, year - min_year, t);
+		fclose( fp);
+	}
+
+	sort_table(t);
+
+	if (snap_path && !write_snapshot(t, snap_path)) {
+		fprintf( stderr, "cannot write snapshot : %s\n", snap_path);
+		destroy_table(t);
+		return 1;
+	}
+
+	if (query)
+		query_loop(t);
+	else
+		print_table(t);
+	destroy_table(t);
+
+	return 0;
+}
+
+// 스냅샷 모드
+// query가 1이면 테이블을 출력하는 대신 질의를 실행
+// return : 프로그램 종료 코드
+int run_snapshot(const char *path, int query) {
+	tTable *t = open_snapshot(path);
+
+	if (!t) {
+		fprintf( stderr, "cannot open snapshot : %s\n", path);
+		return 1;
+	}
+
+	if (query)
+		query_loop(t);
+	else
+		print_table(t);
+	destroy_table(t);
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 외부 정렬(external sort) 출력
+// 메모리에 모든 이름을 올리지 않고, 최대 max_record개씩 정렬한 run을 임시 파일에 기록한 후
+// run들을 k-way 병합하면서 (이름, 성별)이 같은 레코드를 한 줄로 모아 출력
+
+// 연도 정보를 포함한 레코드
+// 임시 파일에는 name 앞의 필드들과 이름의 바이트들을 차례로 기록 (길이 제한 없음)
+typedef struct {
+	int			name_len;		// 이름의 길이
+	int			year_index;		// 연도 인덱스
+	int			freq;			// 빈도
+	char		sex;			// 성별 M or F
+	const char	*name;			// 이름 (임시 파일에는 기록하지 않음)
+} tXRecord;
+
+#define XRECORD_HEAD	offsetof(tXRecord, name)	// 임시 파일에 기록하는 레코드 머리의 크기
+#define NAME_BYTES		16			// 메모리에 유지하는 이름의 평균 크기 (이름 버퍼 용량)
+
+// 임시 파일에 기록된 run을 읽는 커서
+#define CURSOR_BUF	(1 << 15)	// 커서마다 읽기 버퍼의 크기 (바이트)
+
+typedef struct {
+	FILE		*fp;			// run 임시 파일
+	tXRecord	rec;			// 현재 레코드 (rec.name은 name을 가리킴)
+	char		*name;			// 현재 레코드의 이름 ('\0'으로 끝남)
+	int			name_capacity;	// name의 크기
+} tCursor;
+
+// run 정렬 및 병합을 위한 비교 함수
+// 정렬 기준 : 이름(1순위), 성별(2순위), 연도(3순위)
+int x_compare(const void *r1, const void *r2) {
+	const tXRecord *rec1 = (const tXRecord *)r1;
+	const tXRecord *rec2 = (const tXRecord *)r2;
+	int ret = name_compare(rec1->name, rec1->name_len, rec2->name, rec2->name_len);
+
+	if (ret != 0)
+		return ret;
+	if (rec1->sex != rec2->sex)
+		return rec1->sex - rec2->sex;
+	return rec1->year_index - rec2->year_index;
+}
+
+// 레코드들을 정렬하여 새 임시 파일에 기록
+// return : 임시 파일 포인터, 실패하면 NULL
+static FILE *spill_run(tXRecord *recs, int n) {
+	FILE *fp = tmpfile();
+
+	if (!fp)
+		return NULL;
+	qsort(recs, n, sizeof(tXRecord), x_compare);
+	for (int i = 0; i < n; i++) {
+		fwrite(&recs[i], XRECORD_HEAD, 1, fp);
+		fwrite(recs[i].name, 1, recs[i].name_len, fp);
+	}
+	rewind(fp);
+
+	return fp;
+}
+
+// 커서의 다음 레코드로 이동
+// return : 레코드가 있으면 1, run의 끝이면 0
+static int cursor_next(tCursor *c) {
+	if (fread(&c->rec, XRECORD_HEAD, 1, c->fp) != 1)
+		return 0;
+	if (c->rec.name_len + 1 > c->name_capacity) {
+		c->name_capacity = (c->rec.name_len + 1) * 2;
+		c->name = realloc(c->name, c->name_capacity);
+	}
+	if (fread(c->name, 1, c->rec.name_len, c->fp) != (size_t)c->rec.name_len)
+		return 0;
+	c->name[c->rec.name_len] = '\0';
+	c->rec.name = c->name;
+	return 1;
+}
+
+#define CURSOR_HEAD(i)	(&cursors[heap[i]].rec)
+
+// 커서 번호의 최소 힙에서 i번째 원소를 아래로 내림
+static void cursor_sift_down(tCursor *cursors, int *heap, int n, int i) {
+	while (1) {
+		int min = i;
+		int l = 2 * i + 1;
+		int r = 2 * i + 2;
+
+		if (l < n && x_compare(CURSOR_HEAD(l), CURSOR_HEAD(min)) < 0) min = l;
+		if (r < n && x_compare(CURSOR_HEAD(r), CURSOR_HEAD(min)) < 0) min = r;
+		if (min == i)
+			break;
+
+		int tmp = heap[i];
+		heap[i] = heap[min];
+		heap[min] = tmp;
+		i = min;
+	}
+}
+
+// (이름, 성별) 한 줄을 출력
+static void out_row(tOut *out, const char *name, char sex, const int *freq, int num_year) {
+	out_str(out, name);
+	out_char(out, '\t');
+	out_char(out, sex);
+	out_char(out, '\t');
+	for (int y = 0; y < num_year; y++) {
+		out_int(out, freq[y]);
+		out_char(out, '\t');
+	}
+	out_char(out, '\n');
+}
+
+// 외부 정렬 모드에서 만든 run 임시 파일들을 닫고, 레코드와 이름 버퍼를 해제
+static void free_spill(tXRecord *recs, char *pool, FILE **runs, int num_run) {
+	for (int k = 0; k < num_run; k++)
+		fclose(runs[k]);
+	free(runs);
+	free(recs);
+	free(pool);
+}
+
+// 외부 정렬 모드
+// 메모리에는 최대 max_record개의 레코드와 그 이름들, run마다 CURSOR_BUF 바이트만 유지
+// return : 프로그램 종료 코드
+int run_external(char **files, int num_file, int max_record) {
+	int min_year, max_year;
+	year_range(files, num_file, &min_year, &max_year);
+	int num_year = max_year - min_year + 1;
+
+	tXRecord *recs = (tXRecord *)malloc(max_record * sizeof(tXRecord));
+	int n = 0;
+	size_t pool_capacity = (size_t)max_record * NAME_BYTES;	// 레코드들의 이름 버퍼
+	size_t pool_len = 0;
+	char *pool = (char *)malloc(pool_capacity);
+	FILE **runs = NULL;
+	int num_run = 0;
+
+	for (int k = 0; k < num_file; k++) {
+		FILE *fp = fopen( files[k], "r");
+		tReader rd;
+		tView view;
+
+		if (!fp || !open_reader(fp, &rd)) {
+			fprintf( stderr, "cannot open file : %s\n", files[k]);
+			if (fp) fclose(fp);
+			free_spill(recs, pool, runs, num_run);
+			return 1;
+		}
+		fprintf( stderr, "Processing [%s]..\n", files[k]);
+
+		int year_index = atoi( &files[k][strlen(files[k])-8]) - min_year;
+		while (next_record(&rd, &view)) {
+			if (n == max_record || (n > 0 && pool_len + view.name_len > pool_capacity)) {
+				runs = realloc(runs, (num_run + 1) * sizeof(FILE *));
+				if ((runs[num_run] = spill_run(recs, n)) == NULL) {
+					fprintf( stderr, "cannot create temporary file\n");
+					close_reader(&rd);
+					fclose(fp);
+					free_spill(recs, pool, runs, num_run);
+					return 1;
+				}
+				num_run++;
+				n = 0;
+				pool_len = 0;
+			}
+			// 비어 있는 이름 버퍼보다 긴 이름
+			if ((size_t)view.name_len > pool_capacity) {
+				pool_capacity = view.name_len;
+				pool = realloc(pool, pool_capacity);
+			}
+			memcpy(pool + pool_len, view.name, view.name_len);
+			recs[n].name = pool + pool_len;
+			recs[n].name_len = view.name_len;
+			pool_len += view.name_len;
+			recs[n].sex = view.sex;
+			recs[n].year_index = year_index;
+			recs[n].freq = view.freq;
+			n++;
+		}
+		close_reader(&rd);
+		fclose(fp);
+	}
+	if (n > 0) {
+		runs = realloc(runs, (num_run + 1) * sizeof(FILE *));
+		if ((runs[num_run] = spill_run(recs, n)) == NULL) {
+			fprintf( stderr, "cannot create temporary file\n");
+			free_spill(recs, pool, runs, num_run);
+			return 1;
+		}
+		num_run++;
+	}
+	free(recs);
+	free(pool);
+
+	fprintf( stderr, "Merging %d run(s)..\n", num_run);
+
+	// k-way 병합
+	tCursor *cursors = (tCursor *)malloc(num_run * sizeof(tCursor));
+	int *heap = (int *)malloc(num_run * sizeof(int));
+	int h = 0;
+	for (int k = 0; k < num_run; k++) {
+		cursors[k].fp = runs[k];
+		cursors[k].name = NULL;
+		cursors[k].name_capacity = 0;
+		setvbuf(runs[k], NULL, _IOFBF, CURSOR_BUF);
+		if (cursor_next(&cursors[k]))
+			heap[h++] = k;
+	}
+	for (int i = h / 2 - 1; i >= 0; i--)
+		cursor_sift_down(cursors, heap, h, i);
+
+	tOut *out = (tOut *)malloc(sizeof(tOut));
+	int *freq = (int *)calloc(num_year, sizeof(int));
+	char *name = NULL;		// 현재 줄의 이름
+	int name_len = 0;
+	int name_capacity = 0;
+	char sex = 0;
+
+	out_init(out, STDOUT_FILENO);
+	while (h > 0) {
+		tXRecord *rec = CURSOR_HEAD(0);
+
+		if (rec->sex != sex || name_compare(rec->name, rec->name_len, name, name_len) != 0) {
+			if (sex != 0)
+				out_row(out, name, sex, freq, num_year);
+			if (rec->name_len + 1 > name_capacity) {
+				name_capacity = (rec->name_len + 1) * 2;
+				name = realloc(name, name_capacity);
+			}
+			memcpy(name, rec->name, rec->name_len + 1);
+			name_len = rec->name_len;
+			sex = rec->sex;
+			memset(freq, 0, num_year * sizeof(int));
+		}
+		freq[rec->year_index] = rec->freq;
+
+		if (!cursor_next(&cursors[heap[0]]))
+			heap[0] = heap[--h];
+		cursor_sift_down(cursors, heap, h, 0);
+	}
+	if (sex != 0)
+		out_row(out, name, sex, freq, num_year);
+	out_flush(out);
+
+	for (int k = 0; k < num_run; k++) {
+		fclose(runs[k]);
+		free(cursors[k].name);
+	}
+	free(runs);
+	free(cursors);
+	free(name);
+	free(heap);
+	free(freq);
+	free(out);
+
+	return 0;
+}
+
+// 모드(LINEAR_SEARCH, BINARY_SEARCH, HASH_SEARCH)에 맞는 로딩 함수로 연도 파일 하나를 이름 구조체에 저장
+void load_names(int mode, FILE *fp, int year_index, tNames *names, tIndex *index) {
+	if (mode == LINEAR_SEARCH)
+	{
+		// 선형탐색 모드
+		load_names_lsearch( fp, year_index, names);
+	}
+	else if (mode == HASH_SEARCH)
+	{
+		// 해시 인덱스 모드 (정렬은 마지막에 한 번만)
+		load_names_hsearch( fp, year_index, names, index);
+	}
+	else // (mode == BINARY_SEARCH)
+	{
+		// 이진탐색 모드 (이름 배열은 항상 정렬되어 있음)
+		load_names_bsearch( fp, year_index, names);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 벤치마크
+// 모드마다 (필요하면 이름을 늘린) 연도 파일을 차례로 읽으며 파일별 로딩 시간, 비교 횟수,
+// 이름 배열을 늘린 횟수, 최대 메모리 사용량(peak RSS)을 탭으로 구분하여 출력
+// 최대 메모리 사용량이 모드끼리 섞이지 않도록 (모드, 배율)마다 자식 프로세스에서 실행
+
+// 연도 파일의 각 레코드를 scale배로 늘린 임시 파일
+// 복사본 k(> 0)의 이름 뒤에는 k를 붙임 ex) Emma -> Emma, Emma1, Emma2, ...
+// return : 임시 파일 포인터, 실패하면 NULL
+FILE *scale_file(FILE *fp, int scale) {
+	FILE *tmp = tmpfile();
+	tReader rd;
+	tView view;
+
+	if (!tmp)
+		return NULL;
+	if (!open_reader(fp, &rd)) {
+		fclose(tmp);
+		return NULL;
+	}
+	while (next_record(&rd, &view)) {
+		for (int k = 0; k < scale; k++) {
+			if (k == 0)
+				fprintf(tmp, "%.*s,%c,%d\n", view.name_len, view.name, view.sex, view.freq);
+			else
+				fprintf(tmp, "%.*s%d,%c,%d\n", view.name_len, view.name, k, view.sex, view.freq);
+		}
+	}
+	close_reader(&rd);
+	rewind(tmp);
+
+	return tmp;
+}
+
+static double elapsed_ms(const struct timespec *t0, const struct timespec *t1) {
+	return (t1->tv_sec - t0->tv_sec) * 1e3 + (t1->tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+// 결과 한 줄을 출력 (통계는 직전 출력 이후의 증가분)
+static void bench_row(char mode, int scale, int files, const char *file, double ms) {
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+	printf("%c\t%d\t%d\t%s\t%.3f\t%lld\t%lld\t%ld\n", mode, scale, files, file, ms,
+		stats.comparisons, stats.grows, ru.ru_maxrss);
+	stats.comparisons = 0;
+	stats.grows = 0;
+}
+
+// 한 모드로 연도 파일들을 읽으며 파일마다 결과를 출력 (마지막 줄은 정렬)
+// return : 성공 0, 실패 1
+int bench_mode(char mode, char **files, int num_file, int scale) {
+	int min_year, max_year;
+	year_range(files, num_file, &min_year, &max_year);
+
+	// 이름 배열은 빈 상태에서 늘어나도록 미리 예약하지 않음 (grows 열)
+	tNames *names = create_names();
+	tIndex *index = create_index();
+	tTable *t = create_table(min_year, max_year - min_year + 1);
+	FILE **fps = (FILE **)calloc(num_file, sizeof(FILE *));	// 연도 파일
+	FILE **ins = (FILE **)calloc(num_file, sizeof(FILE *));	// (늘린) 입력 파일
+	struct timespec t0, t1;
+	int ret = 0;
+
+	for (int k = 0; k < num_file && ret == 0; k++) {
+		fps[k] = fopen(files[k], "r");
+		if (!fps[k]) {
+			fprintf( stderr, "cannot open file : %s\n", files[k]);
+			ret = 1;
+			break;
+		}
+		ins[k] = scale > 1 ? scale_file(fps[k], scale) : fps[k];
+		if (!ins[k]) {
+			fprintf( stderr, "cannot create temporary file\n");
+			ret = 1;
+			break;
+		}
+		if (mode == 'p')	// 모든 파일을 한 번에 병렬로 읽음
+			continue;
+
+		int year_index = atoi( &files[k][strlen(files[k])-8]) - min_year;
+
+		stats.comparisons = 0;
+		stats.grows = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if (mode == 'c')
+			load_table(ins[k], year_index, t);
+		else
+			load_names(mode == 'l' ? LINEAR_SEARCH : mode == 'b' ? BINARY_SEARCH : HASH_SEARCH,
+				ins[k], year_index, names, index);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		bench_row(mode, scale, k + 1, files[k], elapsed_ms(&t0, &t1));
+	}
+
+	if (ret == 0 && mode == 'p') {
+		stats.comparisons = 0;
+		stats.grows = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if (!load_names_parallel(files, ins, num_file, min_year, names))
+			ret = 1;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		bench_row(mode, scale, num_file, "(all)", elapsed_ms(&t0, &t1));
+	}
+
+	if (ret == 0) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if (mode == 'c')
+			sort_table(t);
+		else if (mode != 'b' && mode != 'p')	// 이진탐색과 병렬 모드는 이미 정렬됨
+			qsort(names->data, names->len, sizeof(tName), compare);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		bench_row(mode, scale, num_file, "(sort)", elapsed_ms(&t0, &t1));
+	}
+
+	for (int k = 0; k < num_file; k++) {
+		if (ins[k] && ins[k] != fps[k]) fclose(ins[k]);
+		if (fps[k]) fclose(fps[k]);
+	}
+	free(ins);
+	free(fps);
+	destroy_names(names);
+	destroy_index(index);
+	destroy_table(t);
+
+	return ret;
+}
+
+// 벤치마크 모드
+// modes의 각 모드(l, b, h, p, c)와 배율 1, 2, 4, ..., max_scale마다 자식 프로세스에서 bench_mode를 실행
+// return : 프로그램 종료 코드
+int run_bench(char **files, int num_file, const char *modes, int max_scale) {
+	for (const char *m = modes; *m; m++) {
+		if (strchr("lbhpc", *m) == NULL) {
+			fprintf( stderr, "unknown benchmark mode : %c\n", *m);
+			return 1;
+		}
+	}
+	for (int k = 0; k < num_file; k++) {
+		int year_index = atoi( &files[k][strlen(files[k])-8]) - atoi( &files[0][strlen(files[0])-8]);
+		if (year_index < 0 || year_index >= MAX_YEAR_DURATION) {
+			fprintf( stderr, "year out of range (at most %d years from the first file) : %s\n", MAX_YEAR_DURATION, files[k]);
+			return 1;
+		}
+	}
+
+	printf("mode\tscale\tfiles\tfile\tload_ms\tcomparisons\tgrows\tpeak_rss_kb\n");
+	fflush(stdout);
+
+	for (const char *m = modes; *m; m++) {
+		for (int scale = 1; scale <= max_scale; scale *= 2) {
+			fprintf( stderr, "Benchmarking [-%c] x%d..\n", *m, scale);
+
+			pid_t pid = fork();
+			if (pid == 0) {
+				int ret = bench_mode(*m, files, num_file, scale);
+				fflush(stdout);
+				_exit(ret);
+			}
+
+			int status;
+			if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				return 1;
+		}
+	}
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 함수 정의 (definition)
+
+// 이름 구조체를 초기화
+// len를 0으로, 이름 배열은 MAX_NAMES개의 주소 공간을 예약하고 NAME_SEGMENT개만 사용 가능하게 초기화
+// (예약에 실패하면 capacity를 1로 초기화)
+// return : 구조체 포인터
+tNames *create_names(void)
+{
+	tNames *pnames = (tNames *)malloc( sizeof(tNames));
+	void *p = mmap(NULL, (size_t)MAX_NAMES * sizeof(tName), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	
+	pnames->len = 0;
+	if (p != MAP_FAILED) {
+		pnames->capacity = 0;
+		pnames->data = (tName *)p;
+		pnames->reserved = 1;
+		grow_names(pnames, NAME_SEGMENT);
+	}
+	else {
+		pnames->capacity = 1;
+		pnames->data = (tName *)malloc(pnames->capacity * sizeof(tName));
+		pnames->reserved = 0;
+	}
+	pnames->intern = create_intern();
+
+	return pnames;
+}
+
+// 이름 구조체가 이름을 n개 이상 저장할 수 있도록 용량을 늘림
+// 용량은 2배 이상씩 늘리고, 예약된 주소 공간이면 늘어난 부분을 NAME_SEGMENT 단위로 사용 가능하게 바꿈 (복사 없음)
+// 예약된 주소 공간이 아니면 realloc (어느 경우든 grows 통계에 포함)
+// return : 성공 1, 실패 0 (기존 이름은 그대로 유지)
+int reserve_names(tNames *names, int n) {
+	if (n <= names->capacity)
+		return 1;
+
+	long long capacity = names->capacity > 0 ? names->capacity : 1;
+	while (capacity < n)
+		capacity = capacity * 2;
+
+	if (names->reserved) {
+		if (n > MAX_NAMES)
+			return 0;
+		capacity = (capacity + NAME_SEGMENT - 1) / NAME_SEGMENT * NAME_SEGMENT;
+		if (capacity > MAX_NAMES)
+			capacity = MAX_NAMES;
+		if (mprotect(names->data, (size_t)capacity * sizeof(tName), PROT_READ | PROT_WRITE) != 0)
+			return 0;
+		stats.grows++;
+	}
+	else {
+		if (capacity > MAX_NAMES)
+			capacity = n;
+		tName *data = realloc(names->data, (size_t)capacity * sizeof(tName));
+		if (data == NULL)
+			return 0;
+		names->data = data;
+		stats.grows++;
+	}
+	names->capacity = (int)capacity;
+	return 1;
+}
+
+// reserve_names와 같지만 실패하면 프로그램을 종료
+void grow_names(tNames *names, int n) {
+	if (!reserve_names(names, n)) {
+		fprintf( stderr, "out of memory (%d names)\n", n);
+		exit(1);
+	}
+}
+
+// 연도 파일들의 크기로 이름 구조체에 저장될 이름 수를 추정 (용량 힌트)
+// 레코드 수는 파일 크기 / RECORD_BYTES로 추정하고, 연도마다 대부분의 이름이 반복되므로
+// 가장 큰 파일의 레코드 수에 나머지 파일 레코드 수의 1/8을 더함 (scale : 입력을 늘린 배율)
+// return : 추정한 이름 수
+int estimate_names(char **files, int num_file, int scale) {
+	long long largest = 0, rest = 0;
+	struct stat st;
+
+	for (int k = 0; k < num_file; k++) {
+		if (stat(files[k], &st) != 0)
+			continue;
+		long long records = (long long)st.st_size / RECORD_BYTES * scale;
+		if (records > largest) {
+			rest += largest;
+			largest = records;
+		}
+		else
+			rest += records;
+	}
+	long long hint = largest + rest / 8;
+	return hint > MAX_NAMES ? MAX_NAMES : (int)hint;
+}
+
+// 이름 구조체에 할당된 메모리를 해제
+void destroy_names(tNames *pnames)
+{
+	if (pnames->reserved)
+		munmap(pnames->data, (size_t)MAX_NAMES * sizeof(tName));
+	else
+		free(pnames->data);
+	destroy_intern(pnames->intern);
+	pnames->len = 0;
+	pnames->capacity = 0;
+
+	free(pnames);
+}
+
+// 해시 인덱스를 초기화
+// capacity를 1024로 초기화
+// return : 인덱스 포인터
+tIndex *create_index(void)
+{
+	tIndex *pindex = (tIndex *)malloc( sizeof(tIndex));
+
+	pindex->len = 0;
+	pindex->capacity = 1024;
+	pindex->slot = (int *)calloc(pindex->capacity, sizeof(int));
+
+	return pindex;
+}
+
+// 해시 인덱스에 할당된 메모리를 해제
+void destroy_index(tIndex *pindex)
+{
+	free(pindex->slot);
+	pindex->len = 0;
+	pindex->capacity = 0;
+
+	free(pindex);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+	tNames *names;
+	tIndex *index = NULL;
+	int mode;
+	
+	FILE *fp;
+	int num_year = 0;
+	
+	if (argc <= 2)
+	{
+		fprintf( stderr, "Usage: %s mode FILE...\n", argv[0]);
+		fprintf( stderr, "       %s -c [-w SNAPSHOT] [-q] FILE...\n", argv[0]);
+		fprintf( stderr, "       %s -s [-q] SNAPSHOT\n", argv[0]);
+		fprintf( stderr, "       %s -e [-m MAX_RECORD] FILE...\n", argv[0]);
+		fprintf( stderr, "       %s -B [-m MODES] [-x MAX_SCALE] FILE...\n\n", argv[0]);
+		fprintf( stderr, "mode\n\t-l\n\t\twith linear search\n\t-b\n\t\twith binary search\n");
+		fprintf( stderr, "\t-h\n\t\twith hash index\n\t-p\n\t\twith parallel loading and k-way merge\n");
+		fprintf( stderr, "\t-c\n\t\twith columnar table (no limit on number of years)\n");
+		fprintf( stderr, "\t\t-w SNAPSHOT : also write the table to a binary snapshot\n");
+		fprintf( stderr, "\t-s\n\t\tfrom a binary snapshot written by -c -w\n");
+		fprintf( stderr, "\t-e\n\t\twith external sort (keeps at most MAX_RECORD records in memory, default %d)\n", DEFAULT_MAX_RECORD);
+		fprintf( stderr, "\t-B\n\t\tbenchmark load modes MODES (default lbhpc) on inputs scaled x1, x2, .., MAX_SCALE (default 1)\n");
+		fprintf( stderr, "option\n\t-q\n\t\tread queries (top, rise, fall, rank, total) from stdin instead of printing the table\n");
+		return 1;
+	}
+	
+	if (strcmp( argv[1], "-l") == 0) mode = LINEAR_SEARCH;
+	else if (strcmp( argv[1], "-b") == 0) mode = BINARY_SEARCH;
+	else if (strcmp( argv[1], "-h") == 0) mode = HASH_SEARCH;
+	else if (strcmp( argv[1], "-p") == 0) mode = PARALLEL_MERGE;
+	else if (strcmp( argv[1], "-c") == 0) mode = COLUMNAR;
+	else if (strcmp( argv[1], "-s") == 0) mode = SNAPSHOT;
+	else if (strcmp( argv[1], "-e") == 0) mode = EXTERNAL_SORT;
+	else if (strcmp( argv[1], "-B") == 0) mode = BENCHMARK;
+	else {
+		fprintf( stderr, "unknown mode : %s\n", argv[1]);
+		return 1;
+	}
+	
+	// 열 기반 테이블 모드
+	if (mode == COLUMNAR || mode == SNAPSHOT)
+	{
+		char *snap_path = NULL;
+		int query = 0;
+		int i = 2;
+		
+		// 옵션 (-w SNAPSHOT, -q)
+		for (; i < argc && argv[i][0] == '-'; i++)
+		{
+			if (strcmp( argv[i], "-q") == 0) query = 1;
+			else if (strcmp( argv[i], "-w") == 0 && mode == COLUMNAR && i + 1 < argc) snap_path = argv[++i];
+			else {
+				fprintf( stderr, "unknown option : %s\n", argv[i]);
+				return 1;
+			}
+		}
+		if (i == argc) {
+			fprintf( stderr, "no input file\n");
+			return 1;
+		}
+		
+		// 스냅샷 모드
+		if (mode == SNAPSHOT)
+			return run_snapshot( argv[i], query);
+		return run_table( &argv[i], argc - i, snap_path, query);
+	}
+	
+	// 외부 정렬 모드
+	if (mode == EXTERNAL_SORT)
+	{
+		int max_record = DEFAULT_MAX_RECORD;
+		int i = 2;
+		
+		if (strcmp( argv[i], "-m") == 0 && i + 1 < argc) {
+			max_record = atoi( argv[i + 1]);
+			i += 2;
+		}
+		if (i == argc || max_record <= 0) {
+			fprintf( stderr, "no input file\n");
+			return 1;
+		}
+		return run_external( &argv[i], argc - i, max_record);
+	}
+	
+	// 벤치마크 모드
+	if (mode == BENCHMARK)
+	{
+		const char *modes = "lbhpc";
+		int max_scale = 1;
+		int i = 2;
+		
+		for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+		{
+			if (strcmp( argv[i], "-m") == 0) modes = argv[i + 1];
+			else if (strcmp( argv[i], "-x") == 0) max_scale = atoi( argv[i + 1]);
+			else break;
+		}
+		if (i == argc || argv[i][0] == '-') {
+			fprintf( stderr, "no input file\n");
+			return 1;
+		}
+		return run_bench( &argv[i], argc - i, modes, max_scale);
+	}
+	
+	// 이름 구조체 초기화 (파일 크기로 추정한 이름 수만큼 미리 용량을 확보)
+	names = create_names();
+	reserve_names( names, estimate_names( &argv[2], argc - 2, 1));
+	if (mode == HASH_SEARCH) index = create_index();
+
+	// 첫 연도 알아내기 "yob2009.txt" -> 2009
+	int start_year = atoi( &argv[2][strlen(argv[2])-8]);
+	
+	// tName의 빈도 배열은 MAX_YEAR_DURATION년까지만 저장 가능
+	for (int i = 2; i < argc; i++)
+	{
+		int year_index = atoi( &argv[i][strlen(argv[i])-8]) - start_year;
+		if (year_index < 0 || year_index >= MAX_YEAR_DURATION) {
+			fprintf( stderr, "year out of range (at most %d years from the first file, use -c) : %s\n", MAX_YEAR_DURATION, argv[i]);
+			return 1;
+		}
+	}
+	
+	if (mode == PARALLEL_MERGE)
+	{
+		// 병렬 모드 (연도 파일마다 정렬된 run을 만든 후 병합, 결과는 이미 정렬됨)
+		num_year = argc - 2;
+		if (!load_names_parallel( &argv[2], NULL, num_year, start_year, names)) return 1;
+	}
+	else for (int i = 2; i < argc; i++)
+	{
+		num_year++;
+		fp = fopen( argv[i], "r");
+		if( !fp) {
+			fprintf( stderr, "cannot open file : %s\n", argv[i]);
+			return 1;
+		}
+
+		int year = atoi( &argv[i][strlen(argv[i])-8]); // ex) "yob2009.txt" -> 2009
+		
+		fprintf( stderr, "Processing [%s]..\n", argv[i]);
+		
+		// 연도별 입력 파일(이름 정보)을 구조체에 저장
+		load_names( mode, fp, year-start_year, names, index);
 		fclose( fp);
 
 	}
 	
 	// 정렬 (이름순 (이름이 같은 경우 성별순))
-	qsort( names->data, names->len, sizeof(tName), compare);
+	if (mode == LINEAR_SEARCH || mode == HASH_SEARCH)
+		qsort( names->data, names->len, sizeof(tName), compare);
 	
 	// 이름 구조체를 화면에 출력
 	print_names( names, num_year);
 
 	// 이름 구조체 해제
 	destroy_names( names);
+	if (index) destroy_index( index);
 	
 	return 0;
 }
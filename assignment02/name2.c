@@ -1,159 +1,742 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>	// fstat
 
 #define MAX_YEAR_DURATION	10	// 기간
+#define RECORD_BYTES	16		// 입력 파일의 한 줄 평균 크기 (용량 추정용) ex) "2009\tEmma\tF\t22\n"
 
 // 구조체 선언
+
+// 이름 문자열 arena의 chunk
+// 큰 chunk를 할당한 후 앞에서부터 잘라 쓰며(bump allocation), 저장한 문자열의 주소는 바뀌지 않음
+#define ARENA_CHUNK	(1 << 16)
+
+typedef struct chunk {
+	struct chunk	*next;	// 먼저 할당된 chunk
+	int		used;			// 사용한 바이트 수
+	int		size;			// data의 크기
+	char	data[];
+} tChunk;
+
+// 이름 문자열 저장소 (string interning)
+// 서로 다른 이름은 arena에 한 번만 저장되고 0부터 차례로 32비트 ID를 부여받음
+// 같은 저장소의 이름끼리는 주소(또는 ID)만 비교하여 같은지 판단할 수 있음
 typedef struct {
-	char	name[20];		// 이름
+	int		len;			// 저장된 이름의 수
+	int		capacity;		// str 배열의 용량
+	const char	**str;		// ID -> 이름 문자열
+	tChunk	*arena;			// 가장 최근에 할당된 chunk
+	int		slot_capacity;	// slot의 수 (2의 거듭제곱)
+	int		*slot;			// 해시 테이블 (ID + 1, 0은 빈 slot)
+} tIntern;
+
+typedef struct {
+	const char	*name;		// 이름 (tNames의 intern에 저장된 문자열)
+	unsigned long long	prefix;	// 이름의 앞 8바이트 (big-endian, 비교용)
 	char	sex;			// 성별 M or F
 	int		freq[MAX_YEAR_DURATION]; // 연도별 빈도
 } tName;
 
+// 이름들은 B+ 트리에 정렬된 상태로 저장
+// leaf 노드는 이름 구조체 배열을 갖고, 이름순으로 연결되어 있음 (출력 시 순차 접근)
+#define LEAF_SIZE	32	// leaf 노드에 저장하는 최대 이름 수
+#define FANOUT		64	// 내부 노드의 최대 자식 수
+#define MAX_HEIGHT	16	// 트리의 최대 높이
+
 typedef struct {
-	int		len;		// 배열에 저장된 이름의 수
-	int		capacity;	// 배열의 용량 (배열에 저장 가능한 이름의 수)
-	tName	*data;		// 이름 배열의 포인터
+	const char	*name;		// 이름
+	unsigned long long	prefix;	// 이름의 앞 8바이트 (big-endian)
+	char	sex;			// 성별 M or F
+} tKey;
+
+typedef struct leaf {
+	int		len;				// leaf에 저장된 이름의 수
+	struct leaf	*next;			// 다음 leaf (이름순)
+	tName	data[LEAF_SIZE];	// 정렬된 이름 배열
+} tLeaf;
+
+typedef struct {
+	int		len;				// 자식의 수
+	tKey	key[FANOUT];		// key[i] : child[i]에 저장된 가장 작은 키 (key[0]은 사용하지 않음)
+	void	*child[FANOUT];		// 자식 노드 (높이 1의 노드이면 tLeaf, 아니면 tInner)
+} tInner;
+
+typedef struct {
+	int		len;		// 저장된 이름의 수
+	int		height;		// 트리의 높이 (루트가 leaf이면 0)
+	void	*root;		// 루트 노드
+	tLeaf	*first;		// 가장 왼쪽 leaf
+	tIntern	*intern;	// 이름 문자열 저장소
+	char	*bulk;		// 일괄 적재로 만든 노드들 (한 번에 할당, 노드별로 해제하지 않음)
+	size_t	bulk_size;	// bulk의 크기
 } tNames;
 
+// 일괄 적재를 위해 읽어 둔 입력 한 줄
+typedef struct {
+	const char	*name;		// 이름 (tNames의 intern에 저장된 문자열)
+	unsigned long long	prefix;	// 이름의 앞 8바이트 (big-endian)
+	int		len;			// 이름의 길이
+	int		year;			// 연도
+	int		freq;			// 빈도
+	char	sex;			// 성별 M or F
+} tRecord;
+
+#define RADIX_CUTOFF	32	// 이보다 적은 레코드는 삽입 정렬
+
+// 조회 전용 사본 (Eytzinger 순서)
+// 정렬된 키를 완전 이진 트리의 BFS 순서(1부터 시작)로 배치하여 탐색 경로의 앞부분이 같은 캐시 라인에 모이도록 함
+// 트리에 이름을 더 삽입하면 rec가 가리키는 레코드가 이동할 수 있으므로 다시 만들어야 함
+typedef struct {
+	int		len;		// 저장된 이름의 수
+	tKey	*key;		// key[1..len] : Eytzinger 순서의 키
+	tName	**rec;		// rec[k] : key[k]의 레코드
+} tEytzinger;
+
 // 함수 원형 선언
 
+unsigned long long name_prefix(const char *name);
 int compare(const void *n1, const void *n2);
-int binary_search(const void *key, const void *base, size_t nmemb, size_t size, int(*compare)(const void *, const void *));
+int compare_key(const tName *info, const tKey *key);
+int binary_search(const tName *key, const tName *base, int nmemb, int *found);
+int compare_record(const tRecord *r1, const tRecord *r2);
+void radix_sort(tRecord *rec, tRecord *tmp, int n, int depth);
+void bulk_load(tNames *names, tRecord *rec, int n, int start_year);
+int estimate_records(FILE *fp);
+
+// 길이가 len인 문자열의 해시 값 (FNV-1a)
+unsigned int hash_str(const char *str, int len) {
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < len; i++) {
+		h ^= (unsigned char)str[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// 이름 문자열 저장소를 초기화
+tIntern *create_intern(void) {
+	tIntern *in = (tIntern *)malloc(sizeof(tIntern));
+
+	in->len = 0;
+	in->capacity = 1024;
+	in->str = (const char **)malloc(in->capacity * sizeof(const char *));
+	in->arena = NULL;
+	in->slot_capacity = 2048;
+	in->slot = (int *)calloc(in->slot_capacity, sizeof(int));
+
+	return in;
+}
+
+// 이름 문자열 저장소에 할당된 메모리를 해제 (arena는 chunk 단위로 해제)
+void destroy_intern(tIntern *in) {
+	while (in->arena) {
+		tChunk *next = in->arena->next;
+		free(in->arena);
+		in->arena = next;
+	}
+	free(in->str);
+	free(in->slot);
+	free(in);
+}
+
+// arena에서 size 바이트를 잘라 줌 (현재 chunk가 부족하면 새 chunk 할당)
+static char *arena_alloc(tIntern *in, int size) {
+	if (in->arena == NULL || in->arena->used + size > in->arena->size) {
+		int chunk_size = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+		tChunk *c = (tChunk *)malloc(sizeof(tChunk) + chunk_size);
+		c->next = in->arena;
+		c->used = 0;
+		c->size = chunk_size;
+		in->arena = c;
+	}
+	char *p = in->arena->data + in->arena->used;
+	in->arena->used += size;
+	return p;
+}
+
+// ID의 이름 문자열 (저장소가 해제될 때까지 주소가 바뀌지 않음)
+const char *intern_str(const tIntern *in, int id) {
+	return in->str[id];
+}
+
+// slot 수를 2배로 늘리고 저장된 모든 이름으로 해시 테이블을 다시 구성
+static void rehash_intern(tIntern *in) {
+	free(in->slot);
+	in->slot_capacity = in->slot_capacity * 2;
+	in->slot = (int *)calloc(in->slot_capacity, sizeof(int));
+
+	unsigned int mask = in->slot_capacity - 1;
+	for (int id = 0; id < in->len; id++) {
+		const char *str = intern_str(in, id);
+		unsigned int i = hash_str(str, strlen(str)) & mask;
+		while (in->slot[i] != 0)
+			i = (i + 1) & mask;
+		in->slot[i] = id + 1;
+	}
+}
+
+// 길이가 len인 문자열의 ID (처음 등장한 문자열이면 arena에 저장 후 새 ID 부여)
+int intern_name(tIntern *in, const char *str, int len) {
+	unsigned int mask = in->slot_capacity - 1;
+	unsigned int i = hash_str(str, len) & mask;
+
+	while (in->slot[i] != 0) {
+		const char *p = intern_str(in, in->slot[i] - 1);
+		if (strncmp(p, str, len) == 0 && p[len] == '\0')
+			return in->slot[i] - 1;
+		i = (i + 1) & mask;
+	}
+
+	if (in->len == in->capacity) {
+		in->capacity = in->capacity * 2;
+		in->str = realloc(in->str, in->capacity * sizeof(const char *));
+	}
+
+	char *p = arena_alloc(in, len + 1);
+	memcpy(p, str, len);
+	p[len] = '\0';
+
+	int id = in->len++;
+	in->str[id] = p;
+	in->slot[i] = id + 1;
+
+	// load factor를 1/2 이하로 유지
+	if (in->len * 2 > in->slot_capacity)
+		rehash_intern(in);
+
+	return id;
+}
+
+// '\0'으로 끝나는 문자열을 저장소에 저장하고 저장된 문자열을 돌려줌
+const char *intern_cstr(tIntern *in, const char *str) {
+	return intern_str(in, intern_name(in, str, strlen(str)));
+}
+
+// B+ 트리 노드 탐색
+// return value: key가 들어 있어야 할 자식의 인덱스 (key[i] <= key인 가장 큰 i, 없으면 0)
+// 구간을 절반씩 줄이며 분기 없이(조건부 이동) 탐색하고, 남은 한 칸만 마지막에 비교
+static int inner_find(const tInner *node, const tName *info) {
+	const tKey *p = &node->key[1];
+	int n = node->len - 1;
+	while (n > 1) {
+		int half = n / 2;
+		p += compare_key(info, &p[half - 1]) >= 0 ? half : 0;
+		n -= half;
+	}
+	return (int)(p - &node->key[1]) + (n == 1 && compare_key(info, p) >= 0);
+}
+
+// 내부 노드의 pos 위치에 (key, child)를 삽입
+// 노드가 가득 찬 경우 반으로 나누고 오른쪽 노드를 돌려줌 (*sep에 오른쪽 노드의 가장 작은 키)
+// return : 나누어진 경우 오른쪽 노드, 아니면 NULL
+static tInner *inner_insert(tInner *node, int pos, tKey key, void *child, tKey *sep) {
+	tKey keys[FANOUT + 1];
+	void *children[FANOUT + 1];
+
+	if (node->len < FANOUT) {
+		memmove(&node->key[pos + 1], &node->key[pos], sizeof(tKey) * (node->len - pos));
+		memmove(&node->child[pos + 1], &node->child[pos], sizeof(void *) * (node->len - pos));
+		node->key[pos] = key;
+		node->child[pos] = child;
+		node->len++;
+		return NULL;
+	}
+
+	memcpy(keys, node->key, sizeof(tKey) * pos);
+	memcpy(children, node->child, sizeof(void *) * pos);
+	keys[pos] = key;
+	children[pos] = child;
+	memcpy(&keys[pos + 1], &node->key[pos], sizeof(tKey) * (FANOUT - pos));
+	memcpy(&children[pos + 1], &node->child[pos], sizeof(void *) * (FANOUT - pos));
+
+	tInner *right = (tInner *)malloc(sizeof(tInner));
+	int half = (FANOUT + 1) / 2;
+	node->len = half;
+	right->len = FANOUT + 1 - half;
+	memcpy(node->key, keys, sizeof(tKey) * half);
+	memcpy(node->child, children, sizeof(void *) * half);
+	memcpy(right->key, &keys[half], sizeof(tKey) * right->len);
+	memcpy(right->child, &children[half], sizeof(void *) * right->len);
+	*sep = right->key[0];
+
+	return right;
+}
+
+// (이름, 성별)의 레코드를 찾아 돌려줌 (없으면 정렬 순서에 맞게 새로 삽입)
+// 레코드는 leaf 노드 안에서만 이동하므로 삽입 비용은 O(log n + LEAF_SIZE)
+// return : 레코드 포인터 (다음 삽입 전까지 유효)
+tName *upsert_name(tNames *names, const tName *info) {
+	tInner *path[MAX_HEIGHT];
+	int slot[MAX_HEIGHT];
+	void *node = names->root;
+
+	for (int h = names->height; h > 0; h--) {
+		path[h] = (tInner *)node;
+		slot[h] = inner_find(path[h], info);
+		node = path[h]->child[slot[h]];
+	}
+
+	tLeaf *leaf = (tLeaf *)node;
+	int found;
+	int pos = binary_search(info, leaf->data, leaf->len, &found);
+	if (found)
+		return &leaf->data[pos];
+
+	names->len++;
+
+	// leaf에 자리가 있는 경우
+	if (leaf->len < LEAF_SIZE) {
+		memmove(&leaf->data[pos + 1], &leaf->data[pos], sizeof(tName) * (leaf->len - pos));
+		leaf->data[pos] = *info;
+		leaf->len++;
+		return &leaf->data[pos];
+	}
+
+	// leaf를 반으로 나눔
+	tLeaf *right = (tLeaf *)malloc(sizeof(tLeaf));
+	int half = LEAF_SIZE / 2;
+	right->len = LEAF_SIZE - half;
+	memcpy(right->data, &leaf->data[half], sizeof(tName) * right->len);
+	leaf->len = half;
+	right->next = leaf->next;
+	leaf->next = right;
+
+	tLeaf *target = pos <= half ? leaf : right;
+	if (target == right) pos -= half;
+	memmove(&target->data[pos + 1], &target->data[pos], sizeof(tName) * (target->len - pos));
+	target->data[pos] = *info;
+	target->len++;
+	tName *ret = &target->data[pos];
+
+	// 부모 노드에 오른쪽 노드를 추가 (부모가 가득 차면 위로 전파)
+	tKey sep = { right->data[0].name, right->data[0].prefix, right->data[0].sex };
+	void *child = right;
+	for (int h = 1; h <= names->height; h++) {
+		child = inner_insert(path[h], slot[h] + 1, sep, child, &sep);
+		if (child == NULL)
+			return ret;
+	}
+
+	// 루트가 나누어진 경우 새 루트를 만듦
+	tInner *root = (tInner *)malloc(sizeof(tInner));
+	root->len = 2;
+	root->child[0] = names->root;
+	root->child[1] = child;
+	root->key[1] = sep;
+	names->root = root;
+	names->height++;
+
+	return ret;
+}
+
+// 입력 파일에서 한 줄을 읽어 레코드에 저장
+// return : 읽은 경우 1, 파일의 끝이면 0
+static int read_record(FILE *fp, tNames *names, tRecord *rec) {
+	char line[30];
+
+	if (fgets(line, sizeof(line), fp) == NULL)
+		return 0;
+
+	char *ptr = strtok(line, "\t");
+	rec->year = atoi(ptr);
+
+	ptr = strtok(NULL, "\t");
+	rec->name = intern_cstr(names->intern, ptr);
+	rec->prefix = name_prefix(rec->name);
+	rec->len = strlen(rec->name);
+
+	ptr = strtok(NULL, "\t");
+	rec->sex = *ptr;
+
+	ptr = strtok(NULL, "\t");
+	rec->freq = atoi(ptr);
+	return 1;
+}
 
 // 연도별 입력 파일을 읽어 이름 정보(연도, 이름, 성별, 빈도)를 이름 구조체에 저장
 // 이미 구조체에 존재하는(저장된) 이름은 해당 연도의 빈도만 저장
 // 새로 등장한 이름은 구조체에 추가
 // 주의사항: 동일 이름이 남/여 각각 사용될 수 있으므로, 이름과 성별을 구별해야 함
 // 주의사항: 정렬 리스트(ordered list)를 유지해야 함 (qsort 함수 사용하지 않음)
-// 이미 등장한 이름인지 검사하기 위해 bsearch 함수를 사용
-// 새로운 이름을 저장할 메모리 공간을 확보하기 위해 memmove 함수를 이용하여 메모리에 저장된 내용을 복사
-// names->capacity는 2배씩 증가
+// 빈 구조체에 읽어 들이는 경우 모든 줄을 버퍼에 모아 한 번 정렬한 후 트리를 한 번에 만듦 (bulk_load)
+// 입력이 이미 (이름, 성별) 순서이면 정렬을 생략하고, 아니면 기수 정렬(radix_sort)
+// 이미 이름이 있는 구조체에는 한 줄씩 B+ 트리에 삽입
 void load_names(FILE *fp, int start_year, tNames *names) {
-	char line[30];
-	int year_index;
+	tRecord rec;
 	tName info;
-	int tfreq;
-	int index1, index2;
-	while (fgets(line, sizeof(line), fp) != NULL) {
+	tName *p;
 
-		char *ptr = strtok(line, "\t");
-		year_index = atoi(ptr);
+	if (names->len == 0) {
+		int n = 0, capacity = estimate_records(fp);
+		int runs = 1;
+		tRecord *buf = (tRecord *)malloc(sizeof(tRecord) * capacity);
 
-		ptr = strtok(NULL, "\t");
-		strcpy(info.name, ptr);
+		while (buf != NULL && read_record(fp, names, &buf[n])) {
+			// 단조 증가 구간(run)의 수를 셈
+			if (n > 0 && compare_record(&buf[n - 1], &buf[n]) > 0)
+				runs++;
+			// 추정보다 줄이 많으면 2배씩 늘림
+			if (++n == capacity) {
+				tRecord *grown = (tRecord *)realloc(buf, sizeof(tRecord) * capacity * 2);
+				if (grown == NULL)
+					free(buf);
+				buf = grown;
+				capacity *= 2;
+			}
+		}
 
-		ptr = strtok(NULL, "\t");
-		info.sex = *ptr;
+		tRecord *tmp = runs > 1 && buf != NULL ? (tRecord *)malloc(sizeof(tRecord) * n) : NULL;
+		if (buf == NULL || (runs > 1 && tmp == NULL)) {
+			fprintf(stderr, "out of memory (%d records)\n", n);
+			exit(1);
+		}
+		if (runs > 1) {
+			radix_sort(buf, tmp, n, 0);
+			free(tmp);
+		}
+		bulk_load(names, buf, n, start_year);
+		free(buf);
+		return;
+	}
 
-		ptr = strtok(NULL, "\t");
-		tfreq = atoi(ptr);
+	while (read_record(fp, names, &rec)) {
+		info.name = rec.name;
+		info.prefix = rec.prefix;
+		info.sex = rec.sex;
+		for (int i = 0; i < MAX_YEAR_DURATION; i++)
+			info.freq[i] = 0;
 
-		if (bsearch(&info, names->data, names->len, sizeof(tName), compare) != NULL) {
+		p = upsert_name(names, &info);
+		p->freq[rec.year-start_year] = rec.freq;
+	}
+}
 
-			index1 = binary_search(&info, names->data, names->len, sizeof(tName), compare);
-			
-			names->data[index1].freq[year_index-start_year] = tfreq;
+// 구조체 배열을 화면에 출력
+void print_names(tNames *names, int num_year) {
+	for (tLeaf *leaf = names->first; leaf != NULL; leaf = leaf->next) {
+		for (int i = 0; i < leaf->len; i++) {
+			printf("%s\t", leaf->data[i].name);
+			printf("%c\t", leaf->data[i].sex);
+			for (int j = 0; j < num_year; j++)
+				printf("%d\t", (leaf->data[i].freq)[j]);
+			printf("\n");
 		}
+	}
+}
 
-		else {
-			if (names->len == names->capacity) {
-				names->capacity = names->capacity * 2;
-				names->data = realloc(names->data, names->capacity * sizeof(tName));
-			}
+// 이름의 앞 8바이트를 big-endian 정수로 만듦 (8바이트보다 짧으면 0으로 채움)
+// 두 prefix의 대소는 strcmp로 비교한 앞 8바이트의 대소와 같음
+unsigned long long name_prefix(const char *name) {
+	unsigned long long prefix = 0;
+	for (int i = 0; i < 8 && name[i]; i++)
+		prefix |= (unsigned long long)(unsigned char)name[i] << (56 - 8 * i);
+	return prefix;
+}
 
-			index2 = binary_search(&info, names->data, names->len, sizeof(tName), compare);
-			
-			memmove(names->data + index2 + 1, names->data + index2, sizeof(tName) * (names->len - index2));
-			
-			strcpy(names->data[index2].name, info.name);
-			
-			names->data[index2].sex = info.sex;
-			
-			for (int i = 0; i < MAX_YEAR_DURATION; i++)
-				names->data[index2].freq[i] = 0;
-			
-			names->data[index2].freq[year_index-start_year] = tfreq;
+// (prefix, 이름, 성별) 순서 비교
+// prefix가 다르면 정수 비교만으로 끝나고, 같은 경우에만 9번째 바이트부터 strcmp
+// prefix의 마지막 바이트가 0이면 두 이름 모두 8바이트 안에서 끝나므로 같은 이름
+static inline int order_key(unsigned long long p1, const char *n1, char s1, unsigned long long p2, const char *n2, char s2) {
+	if (p1 != p2)
+		return (p1 > p2) - (p1 < p2);
+	if (n1 != n2 && (p1 & 0xff) != 0) {
+		int c = strcmp(n1 + 8, n2 + 8);
+		if (c != 0)
+			return c;
+	}
+	return s1 - s2;
+}
 
-			names->len++;
-		}  
+// binary_search를 위한 비교 함수
+int compare(const void *n1, const void *n2) {
+	const tName *info1 = (const tName *)n1;
+	const tName *info2 = (const tName *)n2;
+	return order_key(info1->prefix, info1->name, info1->sex, info2->prefix, info2->name, info2->sex);
+}
+
+// B+ 트리 내부 노드의 키와 비교
+int compare_key(const tName *info, const tKey *key) {
+	return order_key(info->prefix, info->name, info->sex, key->prefix, key->name, key->sex);
+}
+
+// 이진탐색 함수 (lower bound)
+// 한 번의 비교로 구간을 절반씩 줄이며 분기 없이(조건부 이동) 탐색하고, 발견 여부는 마지막에 한 번만 확인
+// return value: key 이상인 첫 원소의 인덱스 (key가 발견되는 경우 그 인덱스, 아니면 삽입되어야 할 인덱스)
+//				*found : key가 발견되면 1, 아니면 0
+int binary_search(const tName *key, const tName *base, int nmemb, int *found) {
+	const tName *p = base;
+	int n = nmemb;
+	int pos;
+
+	if (n == 0) {
+		*found = 0;
+		return 0;
+	}
+	while (n > 1) {
+		int half = n / 2;
+		p += compare(&p[half - 1], key) < 0 ? half : 0;
+		n -= half;
 	}
+	int c = compare(p, key);
+	pos = (int)(p - base) + (c < 0);
+	*found = (c == 0);
+	return pos;
 }
 
-// 구조체 배열을 화면에 출력
-void print_names(tNames *names, int num_year) {
-	for (int i = 0; i < names->len; i++) {
-		printf("%s\t", names->data[i].name);
-		printf("%c\t", names->data[i].sex);
-		for (int j = 0; j < num_year; j++)
-			printf("%d\t", (names->data[i].freq)[j]);
-		printf("\n");
+// 정렬된 레코드 sorted[]를 중위 순회 순서로 Eytzinger 배열의 k번째 위치부터 채움
+// return : 다음에 채울 sorted의 인덱스
+static int fill_eytzinger(tEytzinger *ez, tName **sorted, int i, int k) {
+	if (k <= ez->len) {
+		i = fill_eytzinger(ez, sorted, i, 2 * k);
+		ez->rec[k] = sorted[i];
+		ez->key[k].name = sorted[i]->name;
+		ez->key[k].prefix = sorted[i]->prefix;
+		ez->key[k].sex = sorted[i]->sex;
+		i = fill_eytzinger(ez, sorted, i + 1, 2 * k + 1);
 	}
+	return i;
 }
 
-// bsearch를 위한 비교 함수
-int compare(const void *n1, const void *n2) {
-	tName * info1 = (tName*)n1;
-	tName* info2 = (tName*)n2;
-	if (strcmp(info1->name, info2->name) == 0) {
-		if (info1->sex == info2->sex)
-			return 0;
-		else if (info1->sex > info2->sex)
-			return 1;
-		else
-			return -1;
-	}
-	else {
-		return strcmp(info1->name, info2->name);
-	}
-}
-
-// 이진탐색 함수
-// return value: key가 발견되는 경우, 배열의 인덱스
-//				key가 발견되지 않는 경우, key가 삽입되어야 할 배열의 인덱스
-int binary_search(const void *key, const void *base, size_t nmemb, size_t size, int(*compare)(const void *, const void *)) {
-	int first = 0;
-	int last = (int)nmemb - 1;
-	int mid;
-	tName * b = (tName*) base;
-	tName * k = (tName*)key;
-	while (first <= last) {
-		mid = (first + last) / 2;
-		if (compare(k, b + mid) == 0) {
-			return mid;
+// 이름 구조체의 조회 전용 사본을 만듦
+// return : 사본 포인터
+tEytzinger *create_eytzinger(tNames *names) {
+	tEytzinger *ez = (tEytzinger *)malloc(sizeof(tEytzinger));
+	tName **sorted = (tName **)malloc(sizeof(tName *) * (names->len + 1));
+	int n = 0;
+
+	for (tLeaf *leaf = names->first; leaf != NULL; leaf = leaf->next)
+		for (int i = 0; i < leaf->len; i++)
+			sorted[n++] = &leaf->data[i];
+
+	ez->len = n;
+	ez->key = (tKey *)malloc(sizeof(tKey) * (n + 1));
+	ez->rec = (tName **)malloc(sizeof(tName *) * (n + 1));
+	fill_eytzinger(ez, sorted, 0, 1);
+	free(sorted);
+	return ez;
+}
+
+// 조회 전용 사본 해제
+void destroy_eytzinger(tEytzinger *ez) {
+	free(ez->key);
+	free(ez->rec);
+	free(ez);
+}
+
+// 조회 전용 사본에서 (이름, 성별)을 찾음
+// k번째 노드의 자식은 2k, 2k+1이므로 비교 결과를 더해 내려가고, 몇 단계 아래의 노드는 미리 캐시로 가져옴
+// 탐색이 끝난 뒤 오른쪽으로 내려간 마지막 단계들을 되돌리면 lower bound의 위치가 됨
+// return : 레코드 포인터 (없으면 NULL)
+tName *find_eytzinger(const tEytzinger *ez, const tName *info) {
+	int k = 1;
+	while (k <= ez->len) {
+		__builtin_prefetch(&ez->key[k * 8]);
+		k = 2 * k + (compare_key(info, &ez->key[k]) > 0);
+	}
+	k >>= __builtin_ffs(~k);
+	if (k != 0 && compare_key(info, &ez->key[k]) == 0)
+		return ez->rec[k];
+	return NULL;
+}
+
+// 입력 파일의 크기로 줄 수를 추정 (일괄 적재 버퍼의 용량 힌트)
+// 크기를 알 수 없는 경우 (파이프 등) 1024
+// return : 추정한 줄 수
+int estimate_records(FILE *fp) {
+	struct stat st;
+
+	if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size / RECORD_BYTES < 1024)
+		return 1024;
+	if (st.st_size / RECORD_BYTES > (1 << 28))
+		return 1 << 28;
+	return (int)(st.st_size / RECORD_BYTES) + 1;
+}
+
+// 레코드의 (이름, 성별) 비교
+int compare_record(const tRecord *r1, const tRecord *r2) {
+	return order_key(r1->prefix, r1->name, r1->sex, r2->prefix, r2->name, r2->sex);
+}
+
+// 기수 정렬의 depth번째 키 바이트
+// 키는 (이름, 이름의 끝, 성별) 순서이며, 이름의 끝(1)은 어떤 문자(2 이상)보다 작음
+// return : 0은 키가 모두 끝난 경우 (같은 키)
+static inline int radix_byte(const tRecord *rec, int depth) {
+	if (depth < rec->len)
+		return (unsigned char)rec->name[depth] + 1;
+	if (depth == rec->len)
+		return 1;
+	if (depth == rec->len + 1)
+		return (unsigned char)rec->sex + 1;
+	return 0;
+}
+
+// (이름, 성별) 순서로 레코드 배열을 정렬 (MSD 기수 정렬, 안정 정렬)
+// depth번째 바이트로 레코드를 나눈 후 각 구간을 다음 바이트로 정렬하고, 작은 구간은 삽입 정렬
+// 같은 키의 레코드는 입력 순서를 유지하므로 같은 연도가 두 번 나오면 나중 줄이 남음
+void radix_sort(tRecord *rec, tRecord *tmp, int n, int depth) {
+	int start[258];
+	int count[258] = { 0 };
+
+	if (n < RADIX_CUTOFF) {
+		for (int i = 1; i < n; i++) {
+			tRecord r = rec[i];
+			int j = i;
+			while (j > 0 && compare_record(&rec[j - 1], &r) > 0) {
+				rec[j] = rec[j - 1];
+				j--;
+			}
+			rec[j] = r;
 		}
-		else if (compare(k, b + mid) > 0) {
-			first = mid + 1;
+		return;
+	}
+
+	for (int i = 0; i < n; i++)
+		count[radix_byte(&rec[i], depth)]++;
+	start[0] = 0;
+	for (int c = 1; c < 258; c++)
+		start[c] = start[c - 1] + count[c - 1];
+	for (int i = 0; i < n; i++)
+		tmp[start[radix_byte(&rec[i], depth)]++] = rec[i];
+	memcpy(rec, tmp, sizeof(tRecord) * n);
+
+	// 구간 0은 키가 모두 같으므로 더 나누지 않음
+	for (int c = 1, first = count[0]; c < 258; first += count[c], c++)
+		if (count[c] > 1)
+			radix_sort(rec + first, tmp, count[c], depth + 1);
+}
+
+// 노드의 가장 작은 키 (가장 왼쪽 leaf의 첫 이름)
+static tKey min_key(void *node, int height) {
+	for (; height > 0; height--)
+		node = ((tInner *)node)->child[0];
+	tName *first = &((tLeaf *)node)->data[0];
+	tKey key = { first->name, first->prefix, first->sex };
+	return key;
+}
+
+// 정렬된 레코드 배열 rec[0..n-1]로 빈 이름 구조체의 B+ 트리를 만듦
+// 같은 (이름, 성별)의 레코드는 한 번의 순회로 하나의 이름으로 합치고,
+// leaf와 내부 노드는 한 번에 할당하여 아래 층부터 고르게 채움 (O(n))
+void bulk_load(tNames *names, tRecord *rec, int n, int start_year) {
+	int m = 0;
+	int leaves, inners = 0;
+
+	// 서로 다른 (이름, 성별)의 수 (이름은 intern되어 있으므로 주소만 비교)
+	for (int i = 0; i < n; i++)
+		if (i == 0 || rec[i].name != rec[i - 1].name || rec[i].sex != rec[i - 1].sex)
+			m++;
+	if (m == 0)
+		return;
+
+	leaves = (m + LEAF_SIZE - 1) / LEAF_SIZE;
+	for (int c = leaves; c > 1; ) {
+		c = (c + FANOUT - 1) / FANOUT;
+		inners += c;
+	}
+
+	names->bulk_size = sizeof(tLeaf) * leaves + sizeof(tInner) * inners;
+	names->bulk = (char *)malloc(names->bulk_size);
+	if (names->bulk == NULL) {
+		fprintf(stderr, "out of memory (%d names)\n", m);
+		exit(1);
+	}
+	tLeaf *leaf = (tLeaf *)names->bulk;
+	tInner *inner = (tInner *)(leaf + leaves);
+
+	// leaf 층 : 이름을 leaf에 고르게 나누어 담음
+	for (int l = 0, i = 0, k = 0; l < leaves; l++) {
+		int size = (int)((long long)m * (l + 1) / leaves - (long long)m * l / leaves);
+		leaf[l].len = size;
+		leaf[l].next = l + 1 < leaves ? &leaf[l + 1] : NULL;
+		for (int j = 0; j < size; j++, k++) {
+			tName *p = &leaf[l].data[j];
+			p->name = rec[i].name;
+			p->prefix = rec[i].prefix;
+			p->sex = rec[i].sex;
+			for (int y = 0; y < MAX_YEAR_DURATION; y++)
+				p->freq[y] = 0;
+			for (; i < n && rec[i].name == p->name && rec[i].sex == p->sex; i++)
+				p->freq[rec[i].year - start_year] = rec[i].freq;
 		}
-		else {
-			last = mid - 1;
+	}
+
+	// 내부 노드 층 : 아래 층의 노드(연속으로 배치됨)를 FANOUT개 이하씩 고르게 묶음
+	char *level = (char *)leaf;
+	size_t node_size = sizeof(tLeaf);
+	int count = leaves;
+	int height = 0;
+	while (count > 1) {
+		int parents = (count + FANOUT - 1) / FANOUT;
+		for (int p = 0; p < parents; p++) {
+			int first = (int)((long long)count * p / parents);
+			int last = (int)((long long)count * (p + 1) / parents);
+			inner[p].len = last - first;
+			for (int c = 0; c < inner[p].len; c++) {
+				inner[p].child[c] = level + node_size * (first + c);
+				if (c > 0)
+					inner[p].key[c] = min_key(inner[p].child[c], height);
+			}
 		}
+		level = (char *)inner;
+		node_size = sizeof(tInner);
+		inner += parents;
+		count = parents;
+		height++;
 	}
-	return first;
+
+	// 비어 있던 루트 leaf를 새 트리로 바꿈
+	free(names->root);
+	names->root = level;
+	names->height = height;
+	names->first = leaf;
+	names->len = m;
 }
+
 // 함수 정의
 
 // 이름 구조체 초기화
-// len를 0으로, capacity를 1로 초기화
+// len를 0으로, 루트를 빈 leaf로 초기화
 // return : 구조체 포인터
 tNames *create_names(void)
 {
 	tNames *pnames = (tNames *)malloc( sizeof(tNames));
+	tLeaf *leaf = (tLeaf *)malloc( sizeof(tLeaf));
 	
+	leaf->len = 0;
+	leaf->next = NULL;
+
 	pnames->len = 0;
-	pnames->capacity = 1;
-	pnames->data = (tName *)malloc(pnames->capacity * sizeof(tName));
+	pnames->height = 0;
+	pnames->root = leaf;
+	pnames->first = leaf;
+	pnames->intern = create_intern();
+	pnames->bulk = NULL;
+	pnames->bulk_size = 0;
 
 	return pnames;
 }
 
+// B+ 트리 노드에 할당된 메모리를 해제
+// 일괄 적재로 만든 노드는 names->bulk와 함께 한 번에 해제
+static void destroy_node(tNames *names, void *node, int height)
+{
+	if (height > 0) {
+		tInner *inner = (tInner *)node;
+		for (int i = 0; i < inner->len; i++)
+			destroy_node(names, inner->child[i], height - 1);
+	}
+	if ((char *)node < names->bulk || (char *)node >= names->bulk + names->bulk_size)
+		free(node);
+}
+
 // 이름 구조체에 할당된 메모리를 해제
 void destroy_names(tNames *pnames)
 {
-	free(pnames->data);
+	destroy_node(pnames, pnames->root, pnames->height);
+	free(pnames->bulk);
+	destroy_intern(pnames->intern);
 	pnames->len = 0;
-	pnames->capacity = 0;
 
 	free(pnames);
 }
@@ -163,10 +746,18 @@ int main(int argc, char **argv)
 {
 	tNames *names;
 	FILE *fp;
+	int query = 0;
 	
+	if (argc == 3 && strcmp( argv[1], "-q") == 0)
+	{
+		query = 1;
+		argv++;
+		argc--;
+	}
 	if (argc != 2)
 	{
-		fprintf( stderr, "Usage: %s FILE\n\n", argv[0]);
+		fprintf( stderr, "Usage: %s [-q] FILE\n\n", argv[0]);
+		fprintf( stderr, "  -q : read \"NAME SEX\" queries from stdin after loading\n");
 		return 1;
 	}
 
@@ -187,8 +778,36 @@ int main(int argc, char **argv)
 	
 	fclose( fp);
 	
+	// 조회 모드 : 조회 전용 사본을 만들고 표준 입력의 (이름, 성별)을 찾아 출력
+	if (query)
+	{
+		tEytzinger *ez = create_eytzinger( names);
+		char line[64], name[32];
+		tName info;
+		
+		while (fgets( line, sizeof(line), stdin) != NULL)
+		{
+			if (sscanf( line, "%31s %c", name, &info.sex) != 2)
+				continue;
+			info.name = name;
+			info.prefix = name_prefix( name);
+			
+			tName *p = find_eytzinger( ez, &info);
+			printf( "%s\t%c\t", name, info.sex);
+			if (p == NULL)
+			{
+				printf( "not found\n");
+				continue;
+			}
+			for (int j = 0; j < MAX_YEAR_DURATION; j++)
+				printf( "%d\t", p->freq[j]);
+			printf( "\n");
+		}
+		destroy_eytzinger( ez);
+	}
 	// 이름 구조체를 화면에 출력
-	print_names( names, MAX_YEAR_DURATION);
+	else
+		print_names( names, MAX_YEAR_DURATION);
 
 	// 이름 구조체 해제
 	destroy_names( names);
@@ -1,7 +1,10 @@
 #include <stdlib.h> // malloc
 #include <stdio.h>
-#include <string.h> // strdup, strcmp
+#include <string.h> // strcmp, memcpy
 #include <ctype.h> // toupper
+#include <time.h> // clock_gettime
+#include <sched.h> // sched_yield
+#include <pthread.h> // compile with -pthread
 
 #define QUIT			1
 #define FORWARD_PRINT	2
@@ -13,19 +16,69 @@
 // User structure type definition
 typedef struct 
 {
-	char	*name;
+	const char	*name;	// interned in namePool
 	int		freq;
 } tName;
 
+////////////////////////////////////////////////////////////////////////////////
+// string intern table type definition
+#define ARENA_CHUNK		(1 << 16)
+
+typedef struct chunk
+{
+	struct chunk	*next;	// previously allocated chunk
+	int		used;
+	int		size;
+	char	data[];
+} tChunk;
+
+typedef struct
+{
+	int		count;		// number of interned strings
+	int		capacity;	// capacity of str
+	const char	**str;	// id -> string
+	tChunk	*arena;		// most recent chunk
+	int		slotSize;	// power of 2
+	int		*slot;		// hash table (id + 1, 0 if empty)
+} tIntern;
+
+////////////////////////////////////////////////////////////////////////////////
+// pool allocator type definition
+#define POOL_CHUNK		(1 << 16)
+#define POOL_CLASSES	32		// size classes of 8 bytes (blocks up to 256 bytes)
+
+typedef struct
+{
+	tChunk	*chunks;					// most recent chunk (blocks are cut from it in order)
+	void	*freeList[POOL_CLASSES];	// freed blocks of each size class
+} tPool;
+
 ////////////////////////////////////////////////////////////////////////////////
 // LIST type definition
+#define SKIP_MAX_LEVEL	16	// max number of skip-list levels above the rlink chain
+
 typedef struct node
 {
 	void		*dataPtr;	//tName		*dataPtr;
 	struct node	*llink;
 	struct node	*rlink;
+	struct node	*hlink;		// next node in the same hash bucket
+	int			height;		// number of skip-list levels of this node (0 if not in the tower)
+	int			lock;		// spin lock of a concurrent list (1 if locked)
+	struct node	*skip[];	// skip[i] : next node at level i+1 (level 0 is rlink)
 } NODE;
 
+// node of an unrolled list (several sorted data per node)
+#define UNROLL_SIZE		16	// max number of data in an unrolled node
+
+typedef struct unode
+{
+	int		count;					// number of data in this node (1 ~ UNROLL_SIZE)
+	struct unode	*llink;
+	struct unode	*rlink;
+	void	*dataPtr[UNROLL_SIZE];	// sorted data
+} UNODE;
+
 typedef struct
 {
 	int		count;
@@ -33,6 +86,21 @@ typedef struct
 	NODE	*head;
 	NODE	*rear;
 	int		(*compare)(const void *, const void *); // used in _search function
+	int		skipList;					// 1 if the skip-list tower is used
+	int		levels;						// number of levels in use
+	unsigned int	seed;				// random state for node heights
+	NODE	*top[SKIP_MAX_LEVEL];		// first node at each level
+	NODE	*update[SKIP_MAX_LEVEL];	// predecessors at each level found by the last _search
+	tPool	pool;						// NODEs and data blocks of this list
+	int		unrolled;					// 1 if the list is made of UNODEs (uhead, urear) instead of NODEs
+	UNODE	*uhead;
+	UNODE	*urear;
+	unsigned int	(*hash)(const void *);	// hash of data (NULL if the list has no hash index)
+	int		hashSize;					// number of buckets (power of 2)
+	NODE	**bucket;					// hash index : data -> NODE (chained by hlink)
+	int		concurrent;					// 1 if addNode, removeNode and searchList may be called from several threads
+	int		headLock;					// spin lock for head (the position before the first node)
+	int		poolLock;					// spin lock for pool
 } LIST;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,6 +109,24 @@ typedef struct
 static int _insert(LIST *pList, NODE *pPre, void *dataInPtr);
 static void _delete(LIST *pList, NODE *pPre, NODE *pLoc, void **dataOutPtr);
 static int _search(LIST *pList, NODE **pPre, NODE **pLoc, void *pArgu);
+static int _randomHeight(LIST *pList);
+static void _linkTower(LIST *pList, NODE *pNew);
+static void _unlinkTower(LIST *pList, NODE *pLoc);
+static void *_poolAlloc(tPool *pool, int size);
+static void _poolFree(tPool *pool, void *block, int size);
+static void _poolRelease(tPool *pool);
+static NODE *_hfind(LIST *pList, void *pArgu);
+static void _hinsert(LIST *pList, NODE *pNew);
+static void _hremove(LIST *pList, NODE *pLoc);
+static void _lock(int *lock);
+static void _unlock(int *lock);
+static int _csearch(LIST *pList, NODE **pPre, NODE **pLoc, void *pArgu);
+static void _cunlock(LIST *pList, NODE *pPre, NODE *pLoc);
+static void *_listAlloc(LIST *pList, int size);
+static void _listFree(LIST *pList, void *block, int size);
+static int _usearch(LIST *pList, UNODE **pLoc, int *pIdx, void *pArgu);
+static int _uinsert(LIST *pList, UNODE *pLoc, int idx, void *dataInPtr);
+static void _udelete(LIST *pList, UNODE *pLoc, int idx, void **dataOutPtr);
 int emptyList(LIST *pList);
 
 /* Allocates dynamic memory for a list head node and returns its address to caller
@@ -57,27 +143,119 @@ LIST *createList(int(*compare)(const void *, const void *)) {
 		list->head = NULL;
 		list->rear = NULL;
 		list->compare = compare;
+		list->skipList = 0;
+		list->levels = 0;
+		list->seed = 2463534242u;
+		memset(&list->pool, 0, sizeof(tPool));
+		list->unrolled = 0;
+		list->uhead = NULL;
+		list->urear = NULL;
+		list->hash = NULL;
+		list->hashSize = 0;
+		list->bucket = NULL;
+		list->concurrent = 0;
+		list->headLock = 0;
+		list->poolLock = 0;
 	}
 	return list;
 }
 
+/* Allocates a list with a skip-list tower over the node chain
+	searches, insertions and deletions take O(log n) expected time
+	the node chain (rlink/llink) is the same as in a plain list
+	return	head node pointer
+			NULL if overflow
+*/
+LIST *createSkipList(int(*compare)(const void *, const void *)) {
+	LIST * list = createList(compare);
+	if (list != NULL)
+		list->skipList = 1;
+	return list;
+}
+
+/* Allocates an unrolled list (each node holds up to UNROLL_SIZE sorted data)
+	same interface as a plain list, but scans touch one node per UNROLL_SIZE data
+	return	head node pointer
+			NULL if overflow
+*/
+LIST *createUnrolledList(int(*compare)(const void *, const void *)) {
+	LIST * list = createList(compare);
+	if (list != NULL)
+		list->unrolled = 1;
+	return list;
+}
+
+/* Allocates a list that several threads can share
+	addNode, removeNode, searchList and countList may run concurrently;
+	searches lock nodes hand over hand (each node is locked before its predecessor is released),
+	so threads follow each other down the list and an update only blocks the two or three nodes it links
+	traverseList, traverseListR and destroyList must be called when no other thread uses the list
+	the callback of addNode runs while the node with the duplicated key is locked
+	return	head node pointer
+			NULL if overflow
+*/
+LIST *createConcurrentList(int(*compare)(const void *, const void *)) {
+	LIST * list = createList(compare);
+	if (list != NULL)
+		list->concurrent = 1;
+	return list;
+}
+
+/* Adds a hash index (data -> node) to an empty list of NODEs
+	duplicate checks in addNode, searchList and finding the node in removeNode take O(1) expected time
+	data that compare equal must have the same hash
+	return	1 if successful
+			0 if overflow or the list is unrolled, concurrent or not empty
+*/
+int hashList(LIST *pList, unsigned int(*hash)(const void *)) {
+	if (pList->unrolled || pList->concurrent || pList->count != 0)
+		return 0;
+	pList->bucket = (NODE **)calloc(1024, sizeof(NODE *));
+	if (pList->bucket == NULL)
+		return 0;
+	pList->hashSize = 1024;
+	pList->hash = hash;
+	return 1;
+}
+
 /* Deletes all data in list and recycles memory
+	nodes (and data from allocData) are released chunk by chunk
+	callback	called for each data (NULL if the data need not be released one by one)
 */
 void destroyList(LIST *pList, void(*callback)(void *)) {
 	NODE * pDEL;
-	while (pList->head != NULL) {
-		pDEL = pList->head;
-		pList->head = pList->head->rlink;
-		callback(pDEL->dataPtr);
-		free(pDEL);
-		pList->count -= 1;
-	}
-	if (pList->head == NULL) {
-		pList->rear = NULL;
+	if (callback != NULL) {
+		for (pDEL = pList->head; pDEL != NULL; pDEL = pDEL->rlink)
+			callback(pDEL->dataPtr);
+		for (UNODE *u = pList->uhead; u != NULL; u = u->rlink)
+			for (int i = 0; i < u->count; i++)
+				callback(u->dataPtr[i]);
 	}
+	pList->head = NULL;
+	pList->rear = NULL;
+	pList->uhead = NULL;
+	pList->urear = NULL;
+	pList->count = 0;
+	free(pList->bucket);
+	_poolRelease(&pList->pool);
 	free(pList);
 }
 
+/* Allocates a data block of size bytes (at most 256) from the pool of the list
+	the block is released with the list (destroyList) or by freeData
+	return	block pointer
+			NULL if overflow
+*/
+void *allocData(LIST *pList, int size) {
+	return _listAlloc(pList, size);
+}
+
+/* Returns a data block from allocData to the pool of the list (reused by the next allocation of the same size)
+*/
+void freeData(LIST *pList, void *dataPtr, int size) {
+	_listFree(pList, dataPtr, size);
+}
+
 /* Inserts data into list
 	return	0 if overflow
 			1 if successful
@@ -89,6 +267,31 @@ int addNode(LIST *pList, void *dataInPtr, void(*callback)(const void *, const vo
 	tName* datain = (tName*)dataInPtr;
 	int found;
 	int confirm;
+	if (pList->unrolled) {
+		UNODE* pNode;
+		int idx;
+		if (_usearch(pList, &pNode, &idx, datain)) {	// ̹ ִ ̸
+			callback(pNode->dataPtr[idx], datain);
+			return 2;
+		}
+		if (_uinsert(pList, pNode, idx, datain) == 0)	// overflow Ͼ 
+			return 0;
+		pList->count += 1;
+		return 1;
+	}
+	if (pList->concurrent) {
+		found = _csearch(pList, &pPre, &pLoc, datain);	// pPre, pLoc are locked
+		if (found)					// ̹ ִ ̸
+			callback(pLoc->dataPtr, datain);
+		else if ((confirm = _insert(pList, pPre, datain)) == 1)
+			__atomic_add_fetch(&pList->count, 1, __ATOMIC_RELAXED);
+		_cunlock(pList, pPre, pLoc);
+		return found ? 2 : confirm;
+	}
+	if (pList->hash != NULL && (pLoc = _hfind(pList, datain)) != NULL) {	// ̹ ִ ̸ (ؽ ε)
+		callback(pLoc->dataPtr, datain);
+		return 2;
+	}
 	found = _search(pList, &pPre, &pLoc, datain);
 	if (found == 0) {                                      // search   (list ߰  ߰ų   )
 		confirm = _insert(pList, pPre, datain);
@@ -120,6 +323,40 @@ int removeNode(LIST *pList, void *keyPtr, void **dataOut) {		//tName
 		return 0;
 	}
 	tName* key = (tName*)keyPtr;
+	if (pList->unrolled) {
+		UNODE* pNode;
+		int idx;
+		if (_usearch(pList, &pNode, &idx, key) == 0)
+			return 0;
+		_udelete(pList, pNode, idx, dataOut);
+		pList->count -= 1;
+		return 1;
+	}
+	if (pList->concurrent) {
+		found = _csearch(pList, &pPre, &pLoc, key);	// pPre, pLoc are locked
+		if (found) {
+			NODE* pNext = pLoc->rlink;	// its llink changes, locked from left to right like searches
+			if (pNext != NULL)
+				_lock(&pNext->lock);
+			_delete(pList, pPre, pLoc, dataOut);
+			__atomic_sub_fetch(&pList->count, 1, __ATOMIC_RELAXED);
+			if (pNext != NULL)
+				_unlock(&pNext->lock);
+			pLoc = NULL;			// freed
+		}
+		_cunlock(pList, pPre, pLoc);
+		return found;
+	}
+	if (pList->hash != NULL) {
+		pLoc = _hfind(pList, key);
+		if (pLoc == NULL)
+			return 0;
+		if (pList->skipList == 0) {		//   llink (skip-list  level  尡 ʿϹǷ _search)
+			_delete(pList, pLoc->llink, pLoc, dataOut);
+			pList->count -= 1;
+			return 1;
+		}
+	}
 	found = _search(pList, &pPre, &pLoc, key);
 	if (found == 0) {
 		return 0;
@@ -142,6 +379,28 @@ int searchList(LIST *pList, void *pArgu, void **dataOutPtr) {		//tName
 	NODE* pPre = NULL;
 	NODE* pLoc = NULL;
 	int found;
+	if (pList->unrolled) {
+		UNODE* pNode;
+		int idx;
+		if (_usearch(pList, &pNode, &idx, pArgu) == 0)
+			return 0;
+		*dataOutPtr = pNode->dataPtr[idx];
+		return 1;
+	}
+	if (pList->concurrent) {
+		found = _csearch(pList, &pPre, &pLoc, pArgu);	// pPre, pLoc are locked
+		if (found)
+			*dataOutPtr = pLoc->dataPtr;
+		_cunlock(pList, pPre, pLoc);
+		return found;
+	}
+	if (pList->hash != NULL) {
+		pLoc = _hfind(pList, pArgu);
+		if (pLoc == NULL)
+			return 0;
+		*dataOutPtr = pLoc->dataPtr;
+		return 1;
+	}
 	found = _search(pList, &pPre, &pLoc, pArgu);
 	if (found == 1) {
 		*dataOutPtr = pLoc->dataPtr;
@@ -156,14 +415,14 @@ int searchList(LIST *pList, void *pArgu, void **dataOutPtr) {		//tName
 /* returns number of nodes in list
 */
 int countList(LIST *pList) {
-	return pList->count;
+	return __atomic_load_n(&pList->count, __ATOMIC_RELAXED);
 }
 
 /* returns	1 empty
 			0 list has data
 */
 int emptyList(LIST *pList) {
-	if (pList->count == 0)
+	if (countList(pList) == 0)
 		return 1;
 	else
 		return 0;
@@ -173,6 +432,9 @@ int emptyList(LIST *pList) {
 */
 void traverseList(LIST *pList, void(*callback)(const void *)) {
 	NODE* node;
+	for (UNODE* u = pList->uhead; u != NULL; u = u->rlink)
+		for (int i = 0; i < u->count; i++)
+			callback(u->dataPtr[i]);
 	node = pList->head;
 	while (node != NULL) {
 		callback(node->dataPtr);
@@ -184,6 +446,9 @@ void traverseList(LIST *pList, void(*callback)(const void *)) {
 */
 void traverseListR(LIST *pList, void(*callback)(const void *)) {
 	NODE* node;
+	for (UNODE* u = pList->urear; u != NULL; u = u->llink)
+		for (int i = u->count - 1; i >= 0; i--)
+			callback(u->dataPtr[i]);
 	node = pList->rear;
 	while (node != NULL) {
 		callback(node->dataPtr);
@@ -191,18 +456,235 @@ void traverseListR(LIST *pList, void(*callback)(const void *)) {
 	}
 }
 
+/* internal spin lock functions (waiting threads yield the processor)
+*/
+static void _lock(int *lock) {
+	while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+		while (__atomic_load_n(lock, __ATOMIC_RELAXED))
+			sched_yield();
+}
+
+static void _unlock(int *lock) {
+	__atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+/* internal search function of a concurrent list
+	same as _search, but locks hand over hand from headLock
+	returns with pPre (headLock if pPre is NULL) and pLoc (if not NULL) locked; release them with _cunlock
+	return	1 found
+			0 not found
+*/
+static int _csearch(LIST *pList, NODE **pPre, NODE **pLoc, void *pArgu) {
+	int *preLock = &pList->headLock;
+	_lock(preLock);
+	*pPre = NULL;
+	*pLoc = pList->head;
+	while (*pLoc != NULL) {
+		_lock(&(*pLoc)->lock);
+		int cmp = pList->compare(pArgu, (*pLoc)->dataPtr);
+		if (cmp <= 0)
+			return cmp == 0;
+		_unlock(preLock);
+		preLock = &(*pLoc)->lock;
+		*pPre = *pLoc;
+		*pLoc = (*pLoc)->rlink;
+	}
+	return 0;
+}
+
+/* internal function releasing the locks taken by _csearch
+*/
+static void _cunlock(LIST *pList, NODE *pPre, NODE *pLoc) {
+	if (pLoc != NULL)
+		_unlock(&pLoc->lock);
+	_unlock(pPre == NULL ? &pList->headLock : &pPre->lock);
+}
+
+/* internal allocation functions for nodes and data of a list (the pool is locked in a concurrent list)
+*/
+static void *_listAlloc(LIST *pList, int size) {
+	if (pList->concurrent == 0)
+		return _poolAlloc(&pList->pool, size);
+	_lock(&pList->poolLock);
+	void *block = _poolAlloc(&pList->pool, size);
+	_unlock(&pList->poolLock);
+	return block;
+}
+
+static void _listFree(LIST *pList, void *block, int size) {
+	if (pList->concurrent == 0) {
+		_poolFree(&pList->pool, block, size);
+		return;
+	}
+	_lock(&pList->poolLock);
+	_poolFree(&pList->pool, block, size);
+	_unlock(&pList->poolLock);
+}
+
+/* internal pool allocation
+	reuses a freed block of the same size class, or cuts a new block from the current chunk
+	return	block pointer (8-byte aligned)
+			NULL if overflow
+*/
+static void *_poolAlloc(tPool *pool, int size) {
+	int cls = (size + 7) / 8 - 1;
+	void *block = pool->freeList[cls];
+	if (block != NULL) {
+		pool->freeList[cls] = *(void **)block;
+		return block;
+	}
+	size = (cls + 1) * 8;
+	if (pool->chunks == NULL || pool->chunks->used + size > pool->chunks->size) {
+		tChunk *c = (tChunk *)malloc(sizeof(tChunk) + POOL_CHUNK);
+		if (c == NULL)
+			return NULL;
+		c->next = pool->chunks;
+		c->used = 0;
+		c->size = POOL_CHUNK;
+		pool->chunks = c;
+	}
+	block = pool->chunks->data + pool->chunks->used;
+	pool->chunks->used += size;
+	return block;
+}
+
+/* internal pool free function (pushes the block on the free list of its size class)
+*/
+static void _poolFree(tPool *pool, void *block, int size) {
+	int cls = (size + 7) / 8 - 1;
+	*(void **)block = pool->freeList[cls];
+	pool->freeList[cls] = block;
+}
+
+/* internal function releasing all chunks of a pool
+*/
+static void _poolRelease(tPool *pool) {
+	while (pool->chunks != NULL) {
+		tChunk *next = pool->chunks->next;
+		free(pool->chunks);
+		pool->chunks = next;
+	}
+	memset(pool->freeList, 0, sizeof(pool->freeList));
+}
+
+/* internal hash index search function
+	return	node containing the target
+			NULL if not found
+*/
+static NODE *_hfind(LIST *pList, void *pArgu) {
+	NODE *node = pList->bucket[pList->hash(pArgu) & (pList->hashSize - 1)];
+	while (node != NULL && pList->compare(pArgu, node->dataPtr) != 0)
+		node = node->hlink;
+	return node;
+}
+
+/* internal function adding a new node to the hash index (doubles the buckets when count reaches their number)
+*/
+static void _hinsert(LIST *pList, NODE *pNew) {
+	if (pList->hash == NULL)
+		return;
+	if (pList->count + 1 > pList->hashSize) {
+		NODE **bucket = (NODE **)calloc(pList->hashSize * 2, sizeof(NODE *));
+		if (bucket != NULL) {		// ϸ bucket   (chain  )
+			unsigned int mask = pList->hashSize * 2 - 1;
+			for (int i = 0; i < pList->hashSize; i++) {
+				NODE *node = pList->bucket[i];
+				while (node != NULL) {
+					NODE *next = node->hlink;
+					NODE **b = &bucket[pList->hash(node->dataPtr) & mask];
+					node->hlink = *b;
+					*b = node;
+					node = next;
+				}
+			}
+			free(pList->bucket);
+			pList->bucket = bucket;
+			pList->hashSize *= 2;
+		}
+	}
+	NODE **b = &pList->bucket[pList->hash(pNew->dataPtr) & (pList->hashSize - 1)];
+	pNew->hlink = *b;
+	*b = pNew;
+}
+
+/* internal function removing a node from the hash index
+*/
+static void _hremove(LIST *pList, NODE *pLoc) {
+	if (pList->hash == NULL)
+		return;
+	NODE **b = &pList->bucket[pList->hash(pLoc->dataPtr) & (pList->hashSize - 1)];
+	while (*b != pLoc)
+		b = &(*b)->hlink;
+	*b = pLoc->hlink;
+}
+
+/* internal function for node heights
+	each level is kept with probability 1/4 (xorshift random numbers)
+	return	number of skip-list levels for a new node
+*/
+static int _randomHeight(LIST *pList) {
+	int height = 0;
+	unsigned int x = pList->seed;
+	do {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		if ((x & 3) != 0)
+			break;
+		height++;
+	} while (height < SKIP_MAX_LEVEL);
+	pList->seed = x;
+	return height;
+}
+
+/* internal function linking a new node into the skip-list levels
+	uses the predecessors found by the last _search (pList->update)
+*/
+static void _linkTower(LIST *pList, NODE *pNew) {
+	for (int i = 0; i < pNew->height; i++) {
+		if (i >= pList->levels) {		// new level (no predecessor)
+			pList->update[i] = NULL;
+			pList->top[i] = NULL;
+		}
+		NODE *pre = pList->update[i];
+		NODE **next = pre == NULL ? &pList->top[i] : &pre->skip[i];
+		pNew->skip[i] = *next;
+		*next = pNew;
+	}
+	if (pNew->height > pList->levels)
+		pList->levels = pNew->height;
+}
+
+/* internal function unlinking a node from the skip-list levels
+	uses the predecessors found by the last _search (pList->update)
+*/
+static void _unlinkTower(LIST *pList, NODE *pLoc) {
+	for (int i = 0; i < pLoc->height; i++) {
+		NODE *pre = pList->update[i];
+		NODE **next = pre == NULL ? &pList->top[i] : &pre->skip[i];
+		*next = pLoc->skip[i];
+	}
+	while (pList->levels > 0 && pList->top[pList->levels - 1] == NULL)
+		pList->levels--;
+}
+
 /* internal insert function
 	inserts data into a new node
 	return	1 if successful
 			0 if memory overflow
 */
 static int _insert(LIST *pList, NODE *pPre, void *dataInPtr) { //tName
-	NODE* pNew = (NODE*)malloc(sizeof(NODE));
+	int height = pList->skipList ? _randomHeight(pList) : 0;
+	NODE* pNew = (NODE*)_listAlloc(pList, sizeof(NODE) + height * sizeof(NODE*));
 	if (pNew == NULL) {         // list full 
 		return 0;
 	}
 	else {
 		pNew->dataPtr = dataInPtr;
+		pNew->height = height;
+		pNew->lock = 0;
+		_linkTower(pList, pNew);
+		_hinsert(pList, pNew);
 		pNew->llink = pPre;
 		if (pPre == NULL) {
 			if (pList->head == NULL) {                // ִ list 
@@ -236,7 +718,13 @@ static int _insert(LIST *pList, NODE *pPre, void *dataInPtr) { //tName
 */
 static void _delete(LIST *pList, NODE *pPre, NODE *pLoc, void **dataOutPtr) {	//tName
 	*dataOutPtr = pLoc->dataPtr;
-	if (pLoc->llink == NULL) {
+	_unlinkTower(pList, pLoc);
+	_hremove(pList, pLoc);
+	if (pLoc->llink == NULL && pLoc->rlink == NULL) {	//  带 
+		pList->head = NULL;
+		pList->rear = NULL;
+	}
+	else if (pLoc->llink == NULL) {
 		pLoc->rlink->llink = NULL;
 		pList->head = pLoc->rlink;
 	}
@@ -248,20 +736,28 @@ static void _delete(LIST *pList, NODE *pPre, NODE *pLoc, void **dataOutPtr) {	//
 		pLoc->rlink->llink = pLoc->llink;
 		pLoc->llink->rlink = pLoc->rlink;
 	}
-	free(pLoc);
+	_listFree(pList, pLoc, sizeof(NODE) + pLoc->height * sizeof(NODE*));
 }
 
 /* internal search function
 	searches list and passes back address of node
 	containing target and its logical predecessor
+	with the skip-list tower, descends from the top level and saves the predecessor at each level in pList->update
 	return	1 found
 			0 not found
 */
 static int _search(LIST *pList, NODE **pPre, NODE **pLoc, void *pArgu) {
 	*pPre = NULL;
-	*pLoc = pList->head;
-	tName* argu = (tName*)pArgu;
-	while (*pLoc != NULL && strcmp(argu->name, ((tName*)((*pLoc)->dataPtr))->name) > 0) {
+	for (int i = pList->levels - 1; i >= 0; i--) {	// skip-list levels (empty for a plain list)
+		NODE *next = *pPre == NULL ? pList->top[i] : (*pPre)->skip[i];
+		while (next != NULL && pList->compare(pArgu, next->dataPtr) > 0) {
+			*pPre = next;
+			next = next->skip[i];
+		}
+		pList->update[i] = *pPre;
+	}
+	*pLoc = *pPre == NULL ? pList->head : (*pPre)->rlink;
+	while (*pLoc != NULL && pList->compare(pArgu, (*pLoc)->dataPtr) > 0) {
 		*pPre = *pLoc;
 		*pLoc = (*pLoc)->rlink;
 	}
@@ -269,7 +765,7 @@ static int _search(LIST *pList, NODE **pPre, NODE **pLoc, void *pArgu) {
 		return 0;
 	}
 	else {
-		if (strcmp(argu->name, ((tName*)((*pLoc)->dataPtr))->name) == 0)             // list ̸ ã 
+		if (pList->compare(pArgu, (*pLoc)->dataPtr) == 0)                           // list ̸ ã  (intern ̸ ּҷ )
 			return 1;
 		else                                                                          //ãٰ list ߰   
 			return 0;
@@ -277,26 +773,307 @@ static int _search(LIST *pList, NODE **pPre, NODE **pLoc, void *pArgu) {
 	return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/* unrolled list internals
+	nodes are never empty; the data of all nodes from uhead to urear are in order
+*/
+
+/* internal search function of an unrolled list
+	skips nodes whose last data is smaller than the target, then binary searches in the node
+	passes back the node containing the target (or where it should be inserted) and its position in the node
+	return	1 found
+			0 not found
+*/
+static int _usearch(LIST *pList, UNODE **pLoc, int *pIdx, void *pArgu) {
+	UNODE *node = pList->uhead;
+	while (node != NULL && node->rlink != NULL && pList->compare(pArgu, node->dataPtr[node->count - 1]) > 0)
+		node = node->rlink;
+	*pLoc = node;
+	*pIdx = 0;
+	if (node == NULL)                   // ִ Ʈ 
+		return 0;
+
+	int first = 0, last = node->count;
+	while (first < last) {
+		int mid = (first + last) / 2;
+		if (pList->compare(pArgu, node->dataPtr[mid]) > 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	*pIdx = first;
+	return first < node->count && pList->compare(pArgu, node->dataPtr[first]) == 0;
+}
+
+/* internal function allocating an empty unrolled node and linking it after pPre (at the front if pPre is NULL)
+	return	node pointer
+			NULL if overflow
+*/
+static UNODE *_unewNode(LIST *pList, UNODE *pPre) {
+	UNODE *pNew = (UNODE *)_listAlloc(pList, sizeof(UNODE));
+	if (pNew == NULL)
+		return NULL;
+	pNew->count = 0;
+	pNew->llink = pPre;
+	pNew->rlink = pPre == NULL ? pList->uhead : pPre->rlink;
+	if (pNew->rlink == NULL)
+		pList->urear = pNew;
+	else
+		pNew->rlink->llink = pNew;
+	if (pPre == NULL)
+		pList->uhead = pNew;
+	else
+		pPre->rlink = pNew;
+	return pNew;
+}
+
+/* internal function unlinking an unrolled node and returning it to the pool
+*/
+static void _uremoveNode(LIST *pList, UNODE *pLoc) {
+	if (pLoc->llink == NULL)
+		pList->uhead = pLoc->rlink;
+	else
+		pLoc->llink->rlink = pLoc->rlink;
+	if (pLoc->rlink == NULL)
+		pList->urear = pLoc->llink;
+	else
+		pLoc->rlink->llink = pLoc->llink;
+	_listFree(pList, pLoc, sizeof(UNODE));
+}
+
+/* internal insert function of an unrolled list
+	inserts data at position idx of pLoc (found by _usearch); a full node is split in half first
+	return	1 if successful
+			0 if memory overflow
+*/
+static int _uinsert(LIST *pList, UNODE *pLoc, int idx, void *dataInPtr) {
+	if (pLoc == NULL) {                 // ִ list 
+		pLoc = _unewNode(pList, NULL);
+		if (pLoc == NULL)
+			return 0;
+	}
+	else if (pLoc->count == UNROLL_SIZE) {	// 尡     
+		UNODE *right = _unewNode(pList, pLoc);
+		if (right == NULL)
+			return 0;
+		int half = UNROLL_SIZE / 2;
+		right->count = UNROLL_SIZE - half;
+		memcpy(right->dataPtr, &pLoc->dataPtr[half], right->count * sizeof(void *));
+		pLoc->count = half;
+		if (idx > half) {
+			pLoc = right;
+			idx -= half;
+		}
+	}
+	memmove(&pLoc->dataPtr[idx + 1], &pLoc->dataPtr[idx], (pLoc->count - idx) * sizeof(void *));
+	pLoc->dataPtr[idx] = dataInPtr;
+	pLoc->count++;
+	return 1;
+}
+
+/* internal delete function of an unrolled list
+	deletes data at position idx of pLoc and saves it to dataOut
+	a node less than 1/4 full is merged with a neighbor when both fit in one node
+*/
+static void _udelete(LIST *pList, UNODE *pLoc, int idx, void **dataOutPtr) {
+	*dataOutPtr = pLoc->dataPtr[idx];
+	pLoc->count--;
+	memmove(&pLoc->dataPtr[idx], &pLoc->dataPtr[idx + 1], (pLoc->count - idx) * sizeof(void *));
+	if (pLoc->count >= UNROLL_SIZE / 4)
+		return;
+
+	UNODE *left = pLoc->llink, *right = pLoc;	//   ħ
+	if (pLoc->rlink != NULL && (left == NULL || pLoc->rlink->count < left->count)) {
+		left = pLoc;                            //   ħ
+		right = pLoc->rlink;
+	}
+	if (left != NULL && left->count + right->count <= UNROLL_SIZE) {
+		memcpy(&left->dataPtr[left->count], right->dataPtr, right->count * sizeof(void *));
+		left->count += right->count;
+		_uremoveNode(pList, right);
+	}
+	else if (pLoc->count == 0)          //  尡  
+		_uremoveNode(pList, pLoc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* string interning arena
+	each distinct name is stored once in a bump-allocated chunk and gets a 32-bit id
+	interned strings never move, so two interned names are equal iff their addresses are equal
+*/
+static tIntern *namePool = NULL;
+
+/* FNV-1a hash of a string of length len
+*/
+static unsigned int _hashStr(const char *str, int len) {
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < len; i++) {
+		h ^= (unsigned char)str[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/* Allocates an empty intern table
+	return	intern table pointer
+			NULL if overflow
+*/
+tIntern *createIntern(void) {
+	tIntern *in = (tIntern *)malloc(sizeof(tIntern));
+	if (in == NULL)
+		return NULL;
+	in->count = 0;
+	in->capacity = 1024;
+	in->str = (const char **)malloc(in->capacity * sizeof(const char *));
+	in->arena = NULL;
+	in->slotSize = 2048;
+	in->slot = (int *)calloc(in->slotSize, sizeof(int));
+	return in;
+}
+
+/* Releases all chunks of the arena and the intern table
+*/
+void destroyIntern(tIntern *in) {
+	while (in->arena != NULL) {
+		tChunk *next = in->arena->next;
+		free(in->arena);
+		in->arena = next;
+	}
+	free(in->str);
+	free(in->slot);
+	free(in);
+}
+
+/* internal arena allocation (bump pointer, new chunk when the current one is full)
+*/
+static char *_arenaAlloc(tIntern *in, int size) {
+	if (in->arena == NULL || in->arena->used + size > in->arena->size) {
+		int chunkSize = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+		tChunk *c = (tChunk *)malloc(sizeof(tChunk) + chunkSize);
+		c->next = in->arena;
+		c->used = 0;
+		c->size = chunkSize;
+		in->arena = c;
+	}
+	char *p = in->arena->data + in->arena->used;
+	in->arena->used += size;
+	return p;
+}
+
+/* internal rehash function (doubles the hash table)
+*/
+static void _rehashIntern(tIntern *in) {
+	free(in->slot);
+	in->slotSize *= 2;
+	in->slot = (int *)calloc(in->slotSize, sizeof(int));
+
+	unsigned int mask = in->slotSize - 1;
+	for (int id = 0; id < in->count; id++) {
+		unsigned int i = _hashStr(in->str[id], strlen(in->str[id])) & mask;
+		while (in->slot[i] != 0)
+			i = (i + 1) & mask;
+		in->slot[i] = id + 1;
+	}
+}
+
+/* Interns a string
+	return	id of the string (a new id if the string is seen for the first time)
+*/
+int internName(tIntern *in, const char *str) {
+	int len = strlen(str);
+	unsigned int mask = in->slotSize - 1;
+	unsigned int i = _hashStr(str, len) & mask;
+
+	while (in->slot[i] != 0) {
+		if (strcmp(in->str[in->slot[i] - 1], str) == 0)
+			return in->slot[i] - 1;
+		i = (i + 1) & mask;
+	}
+
+	if (in->count == in->capacity) {
+		in->capacity *= 2;
+		in->str = (const char **)realloc(in->str, in->capacity * sizeof(const char *));
+	}
+	char *p = _arenaAlloc(in, len + 1);
+	memcpy(p, str, len + 1);
+
+	int id = in->count++;
+	in->str[id] = p;
+	in->slot[i] = id + 1;
+
+	if (in->count * 2 > in->slotSize)	// load factor <= 1/2
+		_rehashIntern(in);
+	return id;
+}
+
+/* returns the interned copy of str (interns it first if needed)
+*/
+const char *internStr(tIntern *in, const char *str) {
+	int id = internName(in, str);	// may grow in->str
+	return in->str[id];
+}
+
+/* looks up str without interning it
+	return	interned copy of str
+			NULL if str has never been interned
+*/
+const char *findStr(tIntern *in, const char *str) {
+	unsigned int mask = in->slotSize - 1;
+	unsigned int i = _hashStr(str, strlen(str)) & mask;
+
+	while (in->slot[i] != 0) {
+		if (strcmp(in->str[in->slot[i] - 1], str) == 0)
+			return in->str[in->slot[i] - 1];
+		i = (i + 1) & mask;
+	}
+	return NULL;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /* Allocates dynamic memory for a name structure, initialize fields(name, freq) and returns its address to caller
 	return	name structure pointer
 			NULL if overflow
 */
 tName *createName(char *str, int freq) {
+	if (namePool == NULL)
+		namePool = createIntern();
 	tName* names = (tName*)malloc(sizeof(tName));
-	names->name = strdup(str);
+	if (names == NULL || namePool == NULL)
+		return NULL;
+	names->name = internStr(namePool, str);
 	names->freq = freq;
 	return names;
 }
 
 /* Deletes all data in name structure and recycles memory
+	the name itself stays in namePool
 */
 void destroyName(void *pNode) {		//tName
 	tName* dname = (tName*)pNode;
-	free(dname->name);
 	free(dname);
 }
 
+/* Allocates a name structure from the pool of pList (same as createName, released with the list)
+	return	name structure pointer
+			NULL if overflow
+*/
+tName *createListName(LIST *pList, char *str, int freq) {
+	if (namePool == NULL)
+		namePool = createIntern();
+	tName* names = (tName*)allocData(pList, sizeof(tName));
+	if (names == NULL || namePool == NULL)
+		return NULL;
+	names->name = internStr(namePool, str);
+	names->freq = freq;
+	return names;
+}
+
+/* Returns a name structure from createListName to the pool of pList
+*/
+void destroyListName(LIST *pList, void *pNode) {		//tName
+	freeData(pList, pNode, sizeof(tName));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /* gets user's input
 */
@@ -327,9 +1104,20 @@ int get_action()
 // for createList function
 int cmpName( const void* pName1, const void* pName2)
 {
+	if (((tName *)pName1)->name == ((tName *)pName2)->name)
+		return 0;
 	return strcmp( ((tName *)pName1)->name, ((tName *)pName2)->name);
 }
 
+// hash of the name in name structure (interned names are hashed by address)
+// for hashList function
+unsigned int hashName( const void* pName)
+{
+	unsigned long long h = (unsigned long long)(size_t)((tName *)pName)->name;
+	h *= 0x9E3779B97F4A7C15ULL;
+	return (unsigned int)(h >> 32);
+}
+
 // prints name and freq in name structure
 // for traverseList and traverseListR functions
 void print_name(const void *dataPtr)
@@ -344,6 +1132,262 @@ void increse_freq(const void *dataOutPtr, const void *dataInPtr)
 	((tName *)dataOutPtr)->freq += ((tName *)dataInPtr)->freq;
 }
 
+// elapsed time in nanoseconds
+static long long elapsed_ns( const struct timespec *t0, const struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) * 1000000000LL + (t1->tv_nsec - t0->tv_nsec);
+}
+
+// for qsort in run_batch function
+static int cmp_latency( const void *p1, const void *p2)
+{
+	long long l1 = *(const long long *)p1, l2 = *(const long long *)p2;
+	return (l1 > l2) - (l1 < l2);
+}
+
+// runs commands (S NAME, D NAME, C) from fp against list without printing each result
+// keys are built on the stack (names that were never loaded are compared as plain strings)
+// prints throughput (ops/sec) and latency percentiles to stdout
+// return	0 if successful, 1 if overflow
+int run_batch( LIST *list, FILE *fp)
+{
+	char cmd[8], str[1024];
+	int num = 0, capacity = 1024;
+	int searched = 0, found = 0, deleted = 0, removed = 0, counted = 0;
+	long long *latency = (long long *)malloc( capacity * sizeof(long long));
+	struct timespec t0, t1, start, end;
+	tName key;
+	void *p;
+	
+	if (!latency) return 1;
+	
+	clock_gettime( CLOCK_MONOTONIC, &start);
+	while (fscanf( fp, "%7s", cmd) == 1)
+	{
+		int action = toupper( cmd[0]);
+		
+		// unknown command: skip the rest of its line so that its argument is not read as a command
+		if (action != 'C' && action != 'S' && action != 'D')
+		{
+			if (fscanf( fp, "%*[^\n]") == EOF) break;
+			continue;
+		}
+		if (action != 'C')
+		{
+			if (fscanf( fp, "%1023s", str) != 1) break;
+			key.name = findStr( namePool, str);
+			if (key.name == NULL) key.name = str;
+			key.freq = 0;
+		}
+		
+		clock_gettime( CLOCK_MONOTONIC, &t0);
+		switch( action)
+		{
+			case 'S':
+				searched++;
+				found += searchList( list, &key, &p);
+				break;
+			
+			case 'D':
+				deleted++;
+				if (removeNode( list, &key, &p))
+				{
+					removed++;
+					destroyListName( list, p);
+				}
+				break;
+			
+			case 'C':
+				counted += countList( list) >= 0;
+				break;
+		}
+		clock_gettime( CLOCK_MONOTONIC, &t1);
+		
+		if (num == capacity)
+		{
+			long long *grown = (long long *)realloc( latency, 2 * capacity * sizeof(long long));
+			if (!grown)
+			{
+				free( latency);
+				return 1;
+			}
+			latency = grown;
+			capacity *= 2;
+		}
+		latency[num++] = elapsed_ns( &t0, &t1);
+	}
+	clock_gettime( CLOCK_MONOTONIC, &end);
+	
+	double sec = elapsed_ns( &start, &end) / 1e9;
+	qsort( latency, num, sizeof(long long), cmp_latency);
+	
+	fprintf( stdout, "%d ops in %.3f s (%.0f ops/sec)\n", num, sec, sec > 0 ? num / sec : 0.0);
+	fprintf( stdout, "search %d (found %d), delete %d (deleted %d), count %d\n", searched, found, deleted, removed, counted);
+	if (num > 0)
+		fprintf( stdout, "latency (ns) p50 %lld, p90 %lld, p99 %lld, p99.9 %lld, max %lld\n",
+			latency[num / 2], latency[(int)(num * 0.9)], latency[(int)(num * 0.99)],
+			latency[(int)(num * 0.999)], latency[num - 1]);
+	
+	free( latency);
+	return 0;
+}
+
+// shared state of the stress test threads
+typedef struct
+{
+	LIST	*list;
+	tName	**rec;		// input lines
+	int		num;		// number of input lines
+	int		numThread;
+	int		phase;		// 1 : add and search, 2 : delete even ids and search odd ids
+	int		errors;		// number of failed checks (atomic)
+} tStress;
+
+typedef struct
+{
+	tStress	*st;
+	int		id;			// thread number (0 ~ numThread - 1)
+} tWorker;
+
+// stress test thread
+// phase 1 : adds every numThread-th line and checks that it can be found right after
+// phase 2 : removes names with even intern ids and checks that names with odd ids are still found
+static void *stress_worker( void *arg)
+{
+	tWorker *w = (tWorker *)arg;
+	tStress *st = w->st;
+	void *p;
+	tName key;
+	
+	if (st->phase == 1)
+	{
+		for (int i = w->id; i < st->num; i += st->numThread)
+		{
+			if (addNode( st->list, st->rec[i], increse_freq) == 0 || !searchList( st->list, st->rec[i], &p))
+				__atomic_add_fetch( &st->errors, 1, __ATOMIC_RELAXED);
+		}
+		return NULL;
+	}
+	for (int id = w->id; id < namePool->count; id += st->numThread)
+	{
+		key.name = namePool->str[id];
+		key.freq = 0;
+		if (id % 2 == 0 && !removeNode( st->list, &key, &p))
+			__atomic_add_fetch( &st->errors, 1, __ATOMIC_RELAXED);
+		if (id % 2 == 1 && !searchList( st->list, &key, &p))
+			__atomic_add_fetch( &st->errors, 1, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+// checks that the list is in order, llink/rlink agree and count is the number of nodes
+// return	number of nodes (*freqSum : sum of freq), -1 if inconsistent
+static int check_list( LIST *list, long long *freqSum)
+{
+	int num = 0;
+	NODE *pre = NULL;
+	
+	*freqSum = 0;
+	for (NODE *node = list->head; node != NULL; pre = node, node = node->rlink)
+	{
+		if (node->llink != pre || (pre && list->compare( pre->dataPtr, node->dataPtr) >= 0) || node->lock)
+			return -1;
+		*freqSum += ((tName *)node->dataPtr)->freq;
+		num++;
+	}
+	if (list->rear != pre || num != countList( list) || list->headLock)
+		return -1;
+	return num;
+}
+
+// runs one phase of the stress test with numThread threads
+// return	elapsed time in seconds
+static double stress_phase( tStress *st, int phase)
+{
+	pthread_t *tid = (pthread_t *)malloc( st->numThread * sizeof(pthread_t));
+	tWorker *w = (tWorker *)malloc( st->numThread * sizeof(tWorker));
+	struct timespec t0, t1;
+	
+	st->phase = phase;
+	clock_gettime( CLOCK_MONOTONIC, &t0);
+	for (int t = 0; t < st->numThread; t++)
+	{
+		w[t].st = st;
+		w[t].id = t;
+		pthread_create( &tid[t], NULL, stress_worker, &w[t]);
+	}
+	for (int t = 0; t < st->numThread; t++)
+		pthread_join( tid[t], NULL);
+	clock_gettime( CLOCK_MONOTONIC, &t1);
+	
+	free( tid);
+	free( w);
+	return elapsed_ns( &t0, &t1) / 1e9;
+}
+
+// stress test of the concurrent list
+// numThread threads add all lines of fp at the same time, then delete half of the names while searching the others
+// after each phase, checks the order, the links, count and the sum of frequencies
+// return	0 if all checks passed, 1 otherwise
+int run_stress( FILE *fp, int numThread)
+{
+	tStress st;
+	char str[1024];
+	int freq, capacity = 1024;
+	long long total = 0, sum;
+	int num, ok = 1;
+	double sec;
+	
+	st.list = createConcurrentList( cmpName);
+	st.rec = (tName **)malloc( capacity * sizeof(tName *));
+	st.num = 0;
+	st.numThread = numThread;
+	st.errors = 0;
+	if (!st.list || !st.rec) return 1;
+	
+	// names are interned before the threads start (namePool is not shared safely)
+	while (fscanf( fp, "%*d\t%1023s\t%*c\t%d", str, &freq) == 2)
+	{
+		if (st.num == capacity)
+		{
+			tName **grown = (tName **)realloc( st.rec, 2 * capacity * sizeof(tName *));
+			if (!grown) return 1;
+			st.rec = grown;
+			capacity *= 2;
+		}
+		st.rec[st.num] = createListName( st.list, str, freq);
+		if (!st.rec[st.num]) return 1;
+		total += freq;
+		st.num++;
+	}
+	int distinct = namePool->count;
+	
+	sec = stress_phase( &st, 1);
+	num = check_list( st.list, &sum);
+	fprintf( stdout, "add    : %d threads, %d lines in %.3f s (%.0f ops/sec), %d names, freq sum %lld\n",
+		numThread, st.num, sec, st.num * 2 / sec, num, sum);
+	if (num != distinct || sum != total || st.errors)
+	{
+		fprintf( stdout, "FAILED: expected %d names, freq sum %lld (%d failed operations)\n", distinct, total, st.errors);
+		ok = 0;
+	}
+	
+	sec = stress_phase( &st, 2);
+	num = check_list( st.list, &sum);
+	fprintf( stdout, "delete : %d threads, %d names in %.3f s (%.0f ops/sec), %d names left\n",
+		numThread, distinct, sec, distinct / sec, num);
+	if (num != distinct / 2 || st.errors)
+	{
+		fprintf( stdout, "FAILED: expected %d names (%d failed operations)\n", distinct / 2, st.errors);
+		ok = 0;
+	}
+	if (ok) fprintf( stdout, "OK\n");
+	
+	destroyList( st.list, NULL);
+	free( st.rec);
+	return ok ? 0 : 1;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 int main( int argc, char **argv)
 {
@@ -356,8 +1400,39 @@ int main( int argc, char **argv)
 	int ret;
 	FILE *fp;
 	
-	if (argc != 2){
-		fprintf( stderr, "usage: %s FILE\n", argv[0]);
+	char kind = 0;
+	int hashed = 0;
+	char *prog = argv[0];
+	char *batch = NULL;
+	int numThread = 0;
+	struct timespec t0, t1;
+	
+	for (; argc > 2 && argv[1][0] == '-'; argv++, argc--)	// options
+	{
+		if (strcmp( argv[1], "-s") == 0 || strcmp( argv[1], "-u") == 0) kind = argv[1][1];	// list variant
+		else if (strcmp( argv[1], "-h") == 0) hashed = 1;
+		else if (strcmp( argv[1], "-b") == 0 && argc > 3)
+		{
+			batch = argv[2];
+			argv++;
+			argc--;
+		}
+		else if (strcmp( argv[1], "-t") == 0 && argc > 3)
+		{
+			numThread = atoi( argv[2]);
+			argv++;
+			argc--;
+		}
+		else break;
+	}
+	if (argc != 2 || (kind == 'u' && hashed) || numThread < 0 || (numThread && (kind || hashed || batch))){
+		fprintf( stderr, "usage: %s [-s | -u] [-h] [-b COMMANDS] FILE\n", prog);
+		fprintf( stderr, "       %s -t THREADS FILE\n", prog);
+		fprintf( stderr, "\t-s : with skip-list index (O(log n) search)\n");
+		fprintf( stderr, "\t-u : with unrolled list (%d names per node)\n", UNROLL_SIZE);
+		fprintf( stderr, "\t-h : with hash index (O(1) duplicate check and search, not with -u)\n");
+		fprintf( stderr, "\t-b : run commands (S NAME, D NAME, C) from COMMANDS and report throughput and latency\n");
+		fprintf( stderr, "\t-t : stress test of the concurrent list with THREADS threads\n");
 		return 1;
 	}
 	
@@ -368,8 +1443,24 @@ int main( int argc, char **argv)
 		return 2;
 	}
 	
+	// stress test mode
+	if (numThread)
+	{
+		ret = run_stress( fp, numThread);
+		fclose( fp);
+		destroyIntern( namePool);
+		return ret;
+	}
+	
 	// creates an empty list
-	list = createList( cmpName);
+	if (kind == 's') list = createSkipList( cmpName);
+	else if (kind == 'u') list = createUnrolledList( cmpName);
+	else list = createList( cmpName);
+	if (list && hashed && !hashList( list, hashName))
+	{
+		destroyList( list, NULL);
+		list = NULL;
+	}
 	if (!list)
 	{
 		printf( "Cannot create list\n");
@@ -378,19 +1469,39 @@ int main( int argc, char **argv)
 	
 	void *p;
 	
+	clock_gettime( CLOCK_MONOTONIC, &t0);
 	while(fscanf( fp, "%*d\t%s\t%*c\t%d", str, &freq) != EOF)
 	{
-		pName = createName( str, freq);
+		pName = createListName( list, str, freq);
 		
 		ret = addNode( list, pName, increse_freq);
 		
 		if (ret == 2) // duplicated
 		{
-			destroyName( pName);
+			destroyListName( list, pName);
 		}
 	}
 	
 	fclose( fp);
+	clock_gettime( CLOCK_MONOTONIC, &t1);
+	
+	// batch mode
+	if (batch)
+	{
+		fp = fopen( batch, "rt");
+		if (!fp)
+		{
+			fprintf( stderr, "Error: cannot open file [%s]\n", batch);
+			return 2;
+		}
+		fprintf( stdout, "loaded %d names in %.3f s\n", countList( list), elapsed_ns( &t0, &t1) / 1e9);
+		ret = run_batch( list, fp);
+		fclose( fp);
+		
+		destroyList( list, NULL);
+		destroyIntern( namePool);
+		return ret ? 100 : 0;
+	}
 	
 	fprintf( stderr, "Select Q)uit, F)orward print, B)ackward print, S)earch, D)elete, C)ount: ");
 	
@@ -402,7 +1513,8 @@ int main( int argc, char **argv)
 		switch( action)
 		{
 			case QUIT:
-				destroyList( list, destroyName);
+				destroyList( list, NULL);	// names are in the pool of the list
+				destroyIntern( namePool);
 				return 0;
 			
 			case FORWARD_PRINT:
@@ -417,7 +1529,7 @@ int main( int argc, char **argv)
 				fprintf( stderr, "Input a string to find: ");
 				fscanf( stdin, "%s", str);
 
-				pName = createName( str, 0);
+				pName = createListName( list, str, 0);
 
 				if (searchList( list, pName, &p))
 				{
@@ -425,23 +1537,23 @@ int main( int argc, char **argv)
 				}
 				else fprintf( stdout, "%s not found\n", str);
 				
-				destroyName( pName);
+				destroyListName( list, pName);
 				break;
 				
 			case DELETE:
 				fprintf( stderr, "Input a string to delete: ");
 				fscanf( stdin, "%s", str);
 				
-				pName = createName( str, 0);
+				pName = createListName( list, str, 0);
 
 				if (removeNode( list, pName, &p))
 				{
 					fprintf( stdout, "(%s, %d) deleted\n", ((tName *)p)->name, ((tName *)p)->freq);
-					destroyName( (tName *)p);
+					destroyListName( list, p);
 				}
 				else fprintf( stdout, "%s not found\n", str);
 				
-				destroyName( pName);
+				destroyListName( list, pName);
 				break;
 			
 			case COUNT:
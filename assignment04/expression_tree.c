@@ -3,26 +3,96 @@
 #include <ctype.h> // isdigit
 #include <assert.h> // assert
 #include <string.h>
+#include <math.h> // NAN
+#include <time.h> // clock_gettime
+#include <pthread.h>
 
-#define MAX_STACK_SIZE	50
+#define MAX_STACK_SIZE	50	// stack size on the C stack (longer expressions allocate their stack)
 
 ////////////////////////////////////////////////////////////////////////////////
-// LIST type definition
-typedef struct node
+// token type definition
+// with a separator (',' or whitespace) in the expression, tokens are separated by them
+//	ex) "12.5,rate,*,3,+" : numbers (12, 3.5, 1e-3), variables (x, rate_2) and operators
+// otherwise every character is a token (digit or operator) unless it has a letter or '.'
+//	ex) "34+5*"
+#define TOKEN_NUM	'#'	// number
+#define TOKEN_VAR	'$'	// variable
+
+typedef struct
+{
+	char		type;	// operator ('+', '-', '*', '/'), TOKEN_NUM, TOKEN_VAR (0 if invalid)
+	float		value;	// value of TOKEN_NUM
+	const char	*str;	// name of TOKEN_VAR (not NUL-terminated)
+	int			len;	// length of the name
+} TOKEN;
+
+////////////////////////////////////////////////////////////////////////////////
+// variable bindings (name -> value)
+typedef struct
+{
+	int		count;
+	int		capacity;
+	char	**name;
+	float	*value;
+} VARS;
+
+////////////////////////////////////////////////////////////////////////////////
+// TREE type definition
+// nodes are stored in one array in postfix order (children before their parent),
+// so a tree is one allocation and the root is the last node
+#define NO_NODE	-1	// child index of a leaf
+
+typedef struct
 {
-	char		data;
-	struct node	*left;
-	struct node	*right;
+	char	data;	// operator ('+', '-', '*', '/'), TOKEN_NUM or TOKEN_VAR
+	float	value;	// value of TOKEN_NUM
+	int		var;	// variable number of TOKEN_VAR (index in the variables of the tree)
+	int		left;	// index of the left child (NO_NODE if leaf)
+	int		right;	// index of the right child
 } NODE;
 
 typedef struct
 {
-	NODE	*root;
+	NODE	*node;		// node array (postfix order)
+	int		count;		// number of nodes
+	int		capacity;	// size of the node array (kept when the tree is rebuilt)
+	int		root;		// index of the root (NO_NODE if empty)
+	VARS	*vars;		// variables in the expression (values are not used)
 } TREE;
 
+////////////////////////////////////////////////////////////////////////////////
+// bytecode type definition
+// one instruction per operator: reg[dst] = reg[src1] op reg[src2]
+#define OP_ADD	0
+#define OP_SUB	1
+#define OP_MUL	2
+#define OP_DIV	3
+
+typedef struct
+{
+	unsigned char	op;		// OP_ADD, OP_SUB, OP_MUL, OP_DIV
+	unsigned short	dst;	// register numbers
+	unsigned short	src1;
+	unsigned short	src2;
+} INSTR;
+
+typedef struct
+{
+	int		numInstr;
+	INSTR	*code;
+	int		numVar;		// registers [0, numVar) : variables (bound by runProgram)
+	int		numConst;	// registers [numVar, numVar + numConst) : constants (preloaded)
+	int		numReg;		// the rest are temporaries
+	float	*reg;		// register file
+	int		result;		// register holding the value of the expression
+} PROGRAM;
+
 ////////////////////////////////////////////////////////////////////////////////
 // Prototype declarations
 
+VARS* createVars(void);
+void destroyVars(VARS* pVars);
+
 /* Allocates dynamic memory for a tree head node and returns its address to caller
 	return	head node pointer
 			NULL if overflow
@@ -33,7 +103,15 @@ TREE* createTree(void) {
 	if (head == NULL)
 		return NULL;
 
-	head->root = NULL;
+	head->node = NULL;
+	head->count = 0;
+	head->capacity = 0;
+	head->root = NO_NODE;
+	head->vars = createVars();
+	if (head->vars == NULL) {
+		free(head);
+		return NULL;
+	}
 
 	return head;
 }
@@ -42,95 +120,260 @@ TREE* createTree(void) {
 */
 void destroyTree(TREE* pTree);
 
-static void _destroy(NODE* root) {
-	if (root != NULL) {
-		_destroy(root->left);
-		_destroy(root->right);
-		free(root);
-	}
+/* internal function appending a node to the node array (the array must have room)
+	return	index of the node
+*/
+static int _makeNode(TREE* pTree, char ch) {
+	NODE* newNode = &pTree->node[pTree->count];
+	newNode->data = ch;
+	newNode->value = 0;
+	newNode->var = -1;
+	newNode->left = NO_NODE;
+	newNode->right = NO_NODE;
+	return pTree->count++;
 }
 
-/*  Allocates dynamic memory for a node and returns its address to caller
-	return	node pointer
+/* Allocates an empty set of variable bindings
+	return	bindings pointer
 			NULL if overflow
 */
-static NODE* _makeNode(char ch) {
-	NODE* newNode = (NODE*)malloc(sizeof(NODE));
-	newNode->data = ch;
-	newNode->left = NULL;
-	newNode->right = NULL;
-	return newNode;
+VARS* createVars(void) {
+	VARS* vars = (VARS*)malloc(sizeof(VARS));
+	if (vars == NULL)
+		return NULL;
+	vars->count = 0;
+	vars->capacity = 0;
+	vars->name = NULL;
+	vars->value = NULL;
+	return vars;
+}
+
+/* Deletes variable bindings and recycles memory
+*/
+void destroyVars(VARS* pVars) {
+	if (pVars) {
+		for (int i = 0; i < pVars->count; i++)
+			free(pVars->name[i]);
+		free(pVars->name);
+		free(pVars->value);
+	}
+	free(pVars);
+}
+
+/* internal function removing all variables
+*/
+static void _clearVars(VARS* pVars) {
+	for (int i = 0; i < pVars->count; i++)
+		free(pVars->name[i]);
+	pVars->count = 0;
+}
+
+/* finds a variable (name of length len)
+	return	variable number
+			-1 if not found
+*/
+int findVar(VARS* pVars, const char* name, int len) {
+	for (int i = 0; i < pVars->count; i++) {
+		if (strncmp(pVars->name[i], name, len) == 0 && pVars->name[i][len] == '\0')
+			return i;
+	}
+	return -1;
+}
+
+/* adds a variable (name of length len) if it is new, and sets its value
+	return	variable number
+			-1 if overflow
+*/
+int setVar(VARS* pVars, const char* name, int len, float value) {
+	int i = findVar(pVars, name, len);
+	if (i < 0) {
+		if (pVars->count == pVars->capacity) {
+			int capacity = pVars->capacity ? pVars->capacity * 2 : 8;
+			char** names = (char**)realloc(pVars->name, capacity * sizeof(char*));
+			if (names == NULL)
+				return -1;
+			pVars->name = names;
+			float* values = (float*)realloc(pVars->value, capacity * sizeof(float));
+			if (values == NULL)
+				return -1;
+			pVars->value = values;
+			pVars->capacity = capacity;
+		}
+		char* copy = (char*)malloc(len + 1);
+		if (copy == NULL)
+			return -1;
+		memcpy(copy, name, len);
+		copy[len] = '\0';
+		i = pVars->count++;
+		pVars->name[i] = copy;
+	}
+	pVars->value[i] = value;
+	return i;
+}
+
+/* returns 1 if expr is written with separators (',' or whitespace) between tokens
+	a single variable or decimal number (ex. "x", "2.5") needs no separator
+*/
+static int _separated(const char* expr) {
+	for (const char* p = expr; *p; p++) {
+		if (*p == ',' || *p == '.' || *p == '_' || isspace((unsigned char)*p) || isalpha((unsigned char)*p))
+			return 1;
+	}
+	return 0;
+}
+
+/* internal tokenizer
+	reads the token at expr[*pos] and moves *pos after it
+	return	1 if a token was read (tok->type is 0 if the token is invalid)
+			0 at the end of expr
+*/
+static int _nextToken(const char* expr, int* pos, int separated, TOKEN* tok) {
+	const char* p = expr + *pos;
+	tok->type = 0;
+
+	if (!separated) {
+		if (*p == '\0')
+			return 0;
+		if (*p >= '0' && *p <= '9') {
+			tok->type = TOKEN_NUM;
+			tok->value = (float)(*p - '0');
+		}
+		else if (*p == '+' || *p == '-' || *p == '*' || *p == '/')
+			tok->type = *p;
+		*pos += 1;
+		return 1;
+	}
+
+	while (*p == ',' || isspace((unsigned char)*p))
+		p++;
+	if (*p == '\0') {
+		*pos = (int)(p - expr);
+		return 0;
+	}
+	const char* end = p;
+	while (*end != '\0' && *end != ',' && !isspace((unsigned char)*end))
+		end++;
+	*pos = (int)(end - expr);
+
+	if (end - p == 1 && (*p == '+' || *p == '-' || *p == '*' || *p == '/')) {
+		tok->type = *p;
+	}
+	else if (isalpha((unsigned char)*p) || *p == '_') {
+		for (const char* q = p; q < end; q++) {
+			if (!isalnum((unsigned char)*q) && *q != '_')
+				return 1;
+		}
+		tok->type = TOKEN_VAR;
+		tok->str = p;
+		tok->len = (int)(end - p);
+	}
+	else {
+		char* num_end;
+		tok->value = strtof(p, &num_end);
+		if (num_end == end)
+			tok->type = TOKEN_NUM;
+	}
+	return 1;
 }
 
 /* converts postfix expression to binary tree
+	the previous contents of pTree are discarded (its node array is reused if large enough)
 	return	1 success
 			0 invalid postfix expression
 */
 int postfix2tree(char* expr, TREE* pTree) {
-	NODE* stack[MAX_STACK_SIZE];
+	int small[MAX_STACK_SIZE];
+	int* stack = small;
+	int size = (int)strlen(expr) + 1;	// upper bound of the number of tokens
 	int top = -1;
-	int i = 0;
-	while (expr + i != NULL) {
-		if (expr[0] < 48 || expr[0] > 57) {
-			break;
-		}
-		if (expr[i] >= 48 && expr[i] <= 57) {
-			stack[top + 1] = _makeNode(expr[i]);
-			top += 1;
-			i++;
-		}
-		else if (expr[i] == '+' || expr[i] == '-' || expr[i] == '*' || expr[i] == '/') {
-			if (top < 1) {
-				break;
-			}
+	int pos = 0;
+	int separated = _separated(expr);
+	int valid = 1;
+	TOKEN tok;
 
-			NODE* op = _makeNode(expr[i]);
-			op->right = stack[top];
+	pTree->count = 0;
+	pTree->root = NO_NODE;
+	_clearVars(pTree->vars);
+	if (size > pTree->capacity) {
+		NODE* node = (NODE*)malloc(size * sizeof(NODE));
+		if (node == NULL)
+			return 0;
+		free(pTree->node);
+		pTree->node = node;
+		pTree->capacity = size;
+	}
+	if (size > MAX_STACK_SIZE) {
+		stack = (int*)malloc(size * sizeof(int));
+		if (stack == NULL)
+			return 0;
+	}
+	while (valid && _nextToken(expr, &pos, separated, &tok)) {
+		if (tok.type == TOKEN_NUM || tok.type == TOKEN_VAR) {
+			int leaf = _makeNode(pTree, tok.type);
+			pTree->node[leaf].value = tok.value;
+			if (tok.type == TOKEN_VAR) {
+				int var = findVar(pTree->vars, tok.str, tok.len);
+				if (var < 0)
+					var = setVar(pTree->vars, tok.str, tok.len, 0);
+				if (var < 0)
+					valid = 0;
+				pTree->node[leaf].var = var;
+			}
+			stack[++top] = leaf;
+		}
+		else if (tok.type != 0 && top >= 1) {
+			int op = _makeNode(pTree, tok.type);
+			pTree->node[op].right = stack[top];
 			top -= 1;
-			op->left = stack[top];
+			pTree->node[op].left = stack[top];
 			stack[top] = op;
-			i++;
 		}
 		else {
-			break;
+			valid = 0;
 		}
 	}
-	if (top == -1) {
-		return 0;
-	}
-	else if (top >= 0) {
-		pTree->root = stack[top];
-	}
-	if (top > 0 || i < strlen(expr)) {
-		for (int j = 0; j < top; j++) {
-			_destroy(stack[j]);
-		}
-		return 0;
+	if (valid && top == 0) {
+		pTree->root = stack[0];
 	}
 	else {
-		return 1;
+		// nothing to free: the nodes stay in the array for the next expression
+		pTree->count = 0;
+		_clearVars(pTree->vars);
+		valid = 0;
 	}
-	return 0;
+	if (stack != small)
+		free(stack);
+	return valid;
 }
 
 /* Print node in tree using inorder traversal
 */
 void traverseTree(TREE* pTree);
 
+/* internal function printing a leaf or an operator
+*/
+static void _print_node(const NODE* root, VARS* vars) {
+	if (root->data == TOKEN_NUM)
+		printf("%g", root->value);
+	else if (root->data == TOKEN_VAR)
+		printf("%s", vars->name[root->var]);
+	else
+		printf("%c", root->data);
+}
+
 /* internal traversal function
 	an implementation of ALGORITHM 6-6
 */
-static void _traverse(NODE* root) {
-	if (root != NULL) {
-		char ch = root->data;
-		if (ch >= 48 && ch <= 57) {
-			printf("%c", ch);
+static void _traverse(const NODE* node, int root, VARS* vars) {
+	if (root != NO_NODE) {
+		if (node[root].left == NO_NODE) {
+			_print_node(&node[root], vars);
 		}
 		else {
 			printf("(");
-			_traverse(root->left);
-			printf("%c", ch);
-			_traverse(root->right);
+			_traverse(node, node[root].left, vars);
+			_print_node(&node[root], vars);
+			_traverse(node, node[root].right, vars);
 			printf(")");
 		}
 	}
@@ -142,70 +385,497 @@ void printTree(TREE* pTree);
 
 /* internal traversal function
 */
-static void _infix_print(NODE* root, int level) {
-	if (root != NULL) {
-		_infix_print(root->right, level + 1);
+static void _infix_print(const NODE* node, int root, int level, VARS* vars) {
+	if (root != NO_NODE) {
+		_infix_print(node, node[root].right, level + 1, vars);
 		for (int i = 0; i < level; i++) {
 			printf("\t");
 		}
-		printf("%c", root->data);
+		_print_node(&node[root], vars);
 		printf("\n");
-		_infix_print(root->left, level + 1);
+		_infix_print(node, node[root].left, level + 1, vars);
 	}
 }
 
 /* evaluate postfix expression
+	bindings	values of variables (NULL if none; unbound variables are NAN)
 	return	value of expression
 */
-float evalPostfix(char* expr) {
-	float stack[MAX_STACK_SIZE];
+float evalPostfix(char* expr, VARS* bindings) {
+	float small[MAX_STACK_SIZE];
+	float* stack = small;
+	int size = (int)strlen(expr) + 1;
 	int top = -1;
-	int i = 0;
+	int pos = 0;
+	int separated = _separated(expr);
 	float op1 = 0;
 	float op2 = 0;
 	float result;
-	while (expr + i != NULL) {
-		if (expr[i] >= 48 && expr[i] <= 57) {
-			stack[top + 1] = (float)(expr[i] - 48);
-			top += 1;
-			i++;
+	TOKEN tok;
+
+	if (size > MAX_STACK_SIZE) {
+		stack = (float*)malloc(size * sizeof(float));
+		if (stack == NULL)
+			return NAN;
+	}
+	while (_nextToken(expr, &pos, separated, &tok)) {
+		if (tok.type == TOKEN_NUM) {
+			stack[++top] = tok.value;
+		}
+		else if (tok.type == TOKEN_VAR) {
+			int v = bindings ? findVar(bindings, tok.str, tok.len) : -1;
+			stack[++top] = v >= 0 ? bindings->value[v] : NAN;
 		}
 		else {
-			if (expr[i] == '+') {
-				op1 = stack[top];
-				top -= 1;
-				op2 = stack[top];
+			if (tok.type == 0 || top < 1)
+				break;
+			op1 = stack[top];
+			top -= 1;
+			op2 = stack[top];
+			if (tok.type == '+')
 				stack[top] = op2 + op1;
-				i++;
-			}
-			else if (expr[i] == '*') {
-				op1 = stack[top];
-				top -= 1;
-				op2 = stack[top];
+			else if (tok.type == '*')
 				stack[top] = op2 * op1;
-				i++;
-			}
-			else if (expr[i] == '-') {
-				op1 = stack[top];
-				top -= 1;
-				op2 = stack[top];
+			else if (tok.type == '-')
 				stack[top] = op2 - op1;
-				i++;
-			}
-			else if (expr[i] == '/') {
-				op1 = stack[top];
-				top -= 1;
-				op2 = stack[top];
+			else
 				stack[top] = op2 / op1;
-				i++;
+		}
+	}
+	result = top >= 0 ? stack[top] : NAN;
+	if (stack != small)
+		free(stack);
+	return result;
+}
+
+/* evaluates an expression tree
+	the nodes are visited once in array (postfix) order, so no recursion and no stack
+	vars	values of the variables in the order of the variable numbers (NULL if none)
+	return	value of expression
+			NAN if the tree is empty or overflow
+*/
+float evalTree(TREE* pTree, const float* vars) {
+	float small[MAX_STACK_SIZE];
+	float* val = small;
+	const NODE* node = pTree->node;
+	float result = NAN;
+
+	if (pTree->root == NO_NODE)
+		return NAN;
+	if (pTree->count > MAX_STACK_SIZE) {
+		val = (float*)malloc(pTree->count * sizeof(float));
+		if (val == NULL)
+			return NAN;
+	}
+	for (int i = 0; i < pTree->count; i++) {
+		switch (node[i].data) {
+			case TOKEN_NUM: result = node[i].value; break;
+			case TOKEN_VAR: result = vars[node[i].var]; break;
+			case '+': result = val[node[i].left] + val[node[i].right]; break;
+			case '-': result = val[node[i].left] - val[node[i].right]; break;
+			case '*': result = val[node[i].left] * val[node[i].right]; break;
+			default:  result = val[node[i].left] / val[node[i].right]; break;
+		}
+		val[i] = result;
+	}
+	// the root is the last node
+	if (val != small)
+		free(val);
+	return result;
+}
+
+/* gets the values of the variables of a tree from bindings (in the order of the variable numbers)
+	values	array of pTree->vars->count floats
+	return	number of variables not in bindings (their values are NAN)
+*/
+int bindTree(TREE* pTree, VARS* bindings, float* values) {
+	int unbound = 0;
+	for (int i = 0; i < pTree->vars->count; i++) {
+		const char* name = pTree->vars->name[i];
+		int v = bindings ? findVar(bindings, name, (int)strlen(name)) : -1;
+		values[i] = v >= 0 ? bindings->value[v] : NAN;
+		unbound += v < 0;
+	}
+	return unbound;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// optimization pass
+
+/* internal function returning the hash of a node (children are indices of the new array)
+*/
+static unsigned int _hashNode(const NODE* node) {
+	unsigned int h;
+	if (node->data == TOKEN_NUM)
+		memcpy(&h, &node->value, sizeof(h));	// bit pattern, so 0 and -0 stay apart
+	else if (node->data == TOKEN_VAR)
+		h = (unsigned int)node->var;
+	else
+		h = (unsigned int)node->left * 31u + (unsigned int)node->right;
+	h = (h ^ (unsigned char)node->data) * 2654435761u;
+	return h ^ (h >> 15);
+}
+
+/* internal function comparing two nodes as hash-consing keys
+*/
+static int _sameNode(const NODE* a, const NODE* b) {
+	if (a->data != b->data)
+		return 0;
+	if (a->data == TOKEN_NUM)
+		return memcmp(&a->value, &b->value, sizeof(float)) == 0;
+	if (a->data == TOKEN_VAR)
+		return a->var == b->var;
+	return a->left == b->left && a->right == b->right;
+}
+
+/* internal function adding a node to the new array unless an identical node is already there
+	table	open addressing table of new node indices (-1 if empty), mask + 1 entries
+	return	index of the node in the new array
+*/
+static int _intern(TREE* pTree, const NODE* key, int* table, unsigned int mask) {
+	unsigned int h = _hashNode(key) & mask;
+	while (table[h] != NO_NODE) {
+		if (_sameNode(&pTree->node[table[h]], key))
+			return table[h];
+		h = (h + 1) & mask;
+	}
+	table[h] = pTree->count;
+	pTree->node[pTree->count] = *key;
+	return pTree->count++;
+}
+
+/* internal function returning 1 if node is the constant value
+*/
+static int _isConst(const NODE* node, float value) {
+	return node->data == TOKEN_NUM && node->value == value;
+}
+
+/* optimizes an expression tree in place
+	- constant subtrees are folded (ex. 2,3,*,x,+ -> (6+x))
+	- identities x*1, 1*x, x+0, 0+x, x-0, x/1 are removed (0*x is kept: x may be inf or nan;
+	  x+0 keeps the sign of a -0, which only shows after a division by it)
+	- identical subtrees are shared (the tree becomes a DAG; evalTree computes them once)
+	the nodes stay in postfix order and printing still shows the full expression
+	return	1 success
+			0 overflow (the tree is unchanged)
+*/
+int optimizeTree(TREE* pTree) {
+	int n = pTree->count;
+	if (pTree->root == NO_NODE)	// empty tree (ex. after an invalid expression)
+		return 1;
+	unsigned int size = 2;
+	while (size < 2u * (unsigned int)n)
+		size *= 2;
+	int* map = (int*)malloc((n + size) * sizeof(int));	// old index -> new index, then the table
+	if (map == NULL)
+		return 0;
+	int* table = map + n;
+	for (unsigned int i = 0; i < size; i++)
+		table[i] = NO_NODE;
+
+	// the new array is built over the old one: new index <= old index,
+	// and old node i is read before anything is written at i
+	NODE* node = pTree->node;
+	pTree->count = 0;
+	for (int i = 0; i < n; i++) {
+		NODE key = node[i];
+		if (key.left != NO_NODE) {
+			const NODE* l;
+			const NODE* r;
+			key.left = map[key.left];
+			key.right = map[key.right];
+			l = &node[key.left];
+			r = &node[key.right];
+			if (l->data == TOKEN_NUM && r->data == TOKEN_NUM) {
+				float a = l->value;
+				float b = r->value;
+				switch (key.data) {
+					case '+': key.value = a + b; break;
+					case '-': key.value = a - b; break;
+					case '*': key.value = a * b; break;
+					default:  key.value = a / b; break;
+				}
+				key.data = TOKEN_NUM;
+				key.left = NO_NODE;
+				key.right = NO_NODE;
 			}
-			else {
-				break;
+			else if ((key.data == '*' && _isConst(r, 1)) || (key.data == '/' && _isConst(r, 1))
+				|| ((key.data == '+' || key.data == '-') && _isConst(r, 0))) {
+				map[i] = key.left;
+				continue;
+			}
+			else if ((key.data == '*' && _isConst(l, 1)) || (key.data == '+' && _isConst(l, 0))) {
+				map[i] = key.right;
+				continue;
 			}
 		}
+		map[i] = _intern(pTree, &key, table, size - 1);
 	}
-	result = stack[top];
-	return result;
+	pTree->root = map[pTree->root];
+
+	// folded constants leave their operands behind: keep only the nodes reachable from the root
+	n = pTree->count;
+	for (int i = 0; i < n; i++)
+		map[i] = 0;
+	map[pTree->root] = 1;
+	for (int i = n - 1; i >= 0; i--) {
+		if (map[i] && node[i].left != NO_NODE) {
+			map[node[i].left] = 1;
+			map[node[i].right] = 1;
+		}
+	}
+	pTree->count = 0;
+	for (int i = 0; i < n; i++) {
+		if (map[i]) {
+			NODE* dst = &node[pTree->count];
+			*dst = node[i];
+			if (dst->left != NO_NODE) {
+				dst->left = map[dst->left];
+				dst->right = map[dst->right];
+			}
+			map[i] = pTree->count++;
+		}
+	}
+	pTree->root = map[pTree->root];
+	free(map);
+	return 1;
+}
+
+/* internal function returning the register of a constant (adds it if new)
+*/
+static int _constReg(PROGRAM* prog, float value) {
+	int first = prog->numVar;
+	for (int r = first; r < first + prog->numConst; r++) {
+		if (memcmp(&prog->reg[r], &value, sizeof(float)) == 0)	// bit pattern, so 0 and -0 stay apart
+			return r;
+	}
+	prog->reg[first + prog->numConst] = value;
+	return first + prog->numConst++;
+}
+
+/* internal function assigning registers to the constants of a subtree
+*/
+static void _collect(TREE* pTree, PROGRAM* prog) {
+	for (int i = 0; i < pTree->count; i++) {
+		if (pTree->node[i].data == TOKEN_NUM)
+			_constReg(prog, pTree->node[i].value);
+	}
+}
+
+/* internal compile function
+	emits the instructions of a subtree in postorder
+	the value of an operator at depth d goes to temporary register d, so the left operand
+	(already in register d or a constant) survives while the right one is computed in d + 1
+	an operator shared by several parents (after optimizeTree) gets its own register and is
+	computed only once
+	shared		register of each shared node (-1 if not yet compiled, NO_REG if not shared)
+	nextShared	next free register for shared nodes
+	return	register holding the value of the subtree
+*/
+#define NO_REG	-2
+
+static int _compile(const NODE* node, int root, PROGRAM* prog, int* shared, int* nextShared, int tempBase, int depth) {
+	if (node[root].left == NO_NODE)
+		return node[root].data == TOKEN_VAR ? node[root].var : _constReg(prog, node[root].value);
+	if (shared[root] >= 0)
+		return shared[root];
+
+	INSTR* in;
+	int src1 = _compile(node, node[root].left, prog, shared, nextShared, tempBase, depth);
+	int src2 = _compile(node, node[root].right, prog, shared, nextShared, tempBase, depth + 1);
+	in = &prog->code[prog->numInstr++];
+	switch (node[root].data) {
+		case '+': in->op = OP_ADD; break;
+		case '-': in->op = OP_SUB; break;
+		case '*': in->op = OP_MUL; break;
+		default:  in->op = OP_DIV; break;
+	}
+	in->src1 = src1;
+	in->src2 = src2;
+	if (shared[root] == -1) {
+		in->dst = shared[root] = (*nextShared)++;
+		return in->dst;
+	}
+	in->dst = tempBase + depth;
+	if (tempBase + depth + 1 > prog->numReg)
+		prog->numReg = tempBase + depth + 1;
+	return in->dst;
+}
+
+/* compiles an expression tree (built by postfix2tree) into bytecode
+	the program can be run any number of times without the tree
+	return	program pointer
+			NULL if overflow
+*/
+PROGRAM* compileTree(TREE* pTree) {
+	int n = pTree->count;
+	int numVar = pTree->vars->count;
+	PROGRAM* prog = (PROGRAM*)malloc(sizeof(PROGRAM));
+	if (prog == NULL || n == 0 || numVar + 2 * n + 1 > 65536) {
+		free(prog);
+		return NULL;
+	}
+	prog->code = (INSTR*)malloc(n * sizeof(INSTR));
+	prog->reg = (float*)malloc((numVar + 2 * n + 1) * sizeof(float));	// variables + constants + shared + temporaries
+	int* shared = (int*)malloc(n * sizeof(int));
+	if (prog->code == NULL || prog->reg == NULL || shared == NULL) {
+		free(prog->code);
+		free(prog->reg);
+		free(prog);
+		free(shared);
+		return NULL;
+	}
+	prog->numInstr = 0;
+	prog->numVar = numVar;	// variable registers keep the variable numbers of the tree
+	prog->numConst = 0;
+
+	// operators with more than one parent (only after optimizeTree)
+	int numShared = 0;
+	for (int i = 0; i < n; i++)
+		shared[i] = 0;
+	for (int i = 0; i < n; i++) {
+		if (pTree->node[i].left != NO_NODE) {
+			shared[pTree->node[i].left]++;
+			shared[pTree->node[i].right]++;
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		if (pTree->node[i].left != NO_NODE && shared[i] > 1) {
+			shared[i] = -1;
+			numShared++;
+		}
+		else
+			shared[i] = NO_REG;
+	}
+
+	// constants first, then shared values, so that temporaries start after them
+	_collect(pTree, prog);
+	int nextShared = prog->numVar + prog->numConst;
+	prog->numReg = nextShared + numShared;
+	prog->result = _compile(pTree->node, pTree->root, prog, shared, &nextShared, prog->numReg, 0);
+	free(shared);
+	return prog;
+}
+
+/* runs a compiled expression
+	vars	values of the variables (NULL if the program has none)
+	return	value of expression
+*/
+float runProgram(PROGRAM* prog, const float* vars) {
+	float* reg = prog->reg;
+	const INSTR* in = prog->code;
+	const INSTR* end = in + prog->numInstr;
+
+	for (int i = 0; i < prog->numVar; i++)
+		reg[i] = vars[i];
+	for (; in < end; in++) {
+		float a = reg[in->src1];
+		float b = reg[in->src2];
+		switch (in->op) {
+			case OP_ADD: reg[in->dst] = a + b; break;
+			case OP_SUB: reg[in->dst] = a - b; break;
+			case OP_MUL: reg[in->dst] = a * b; break;
+			case OP_DIV: reg[in->dst] = a / b; break;
+		}
+	}
+	return reg[prog->result];
+}
+
+#if defined(__GNUC__)
+typedef float VEC __attribute__((vector_size(32)));	// 8 lanes (AVX, or two SSE registers)
+#endif
+
+#define BATCH_SIZE	256	// rows per block (the temporaries of a block stay in L1 cache)
+
+/* applies one operator to len rows: d[i] = a[i] OP b[i]
+	d may be the same block as a or b, so loads go through memcpy instead of restrict
+*/
+#if defined(__GNUC__)
+#define BATCH_LOOP(OP) \
+	for (; i + 8 <= len; i += 8) { \
+		VEC va, vb; \
+		memcpy(&va, a + i, sizeof(VEC)); \
+		memcpy(&vb, b + i, sizeof(VEC)); \
+		va = va OP vb; \
+		memcpy(d + i, &va, sizeof(VEC)); \
+	} \
+	for (; i < len; i++) \
+		d[i] = a[i] OP b[i]
+#else
+#define BATCH_LOOP(OP) \
+	for (; i < len; i++) \
+		d[i] = a[i] OP b[i]
+#endif
+
+/* runs a compiled expression over n rows of variable bindings
+	every instruction is applied to a block of rows at a time, so the interpreter overhead
+	is paid once per block and the arithmetic runs in SIMD lanes
+	cols	cols[i][row] is the value of variable i (cols may be NULL if the program has none)
+	out		n floats receiving the values
+	return	1 success
+			0 overflow
+*/
+int runProgramBatch(PROGRAM* prog, const float* const* cols, int n, float* out) {
+	float** rp = (float**)malloc(prog->numReg * sizeof(float*));
+	float* temp = (float*)malloc(((size_t)(prog->numReg - prog->numVar) * BATCH_SIZE + 1) * sizeof(float));
+	if (rp == NULL || temp == NULL) {
+		free(rp);
+		free(temp);
+		return 0;
+	}
+	// constants are broadcast once, temporaries get a block each
+	for (int r = prog->numVar; r < prog->numReg; r++) {
+		rp[r] = temp + (size_t)(r - prog->numVar) * BATCH_SIZE;
+		if (r < prog->numVar + prog->numConst) {
+			for (int i = 0; i < BATCH_SIZE; i++)
+				rp[r][i] = prog->reg[r];
+		}
+	}
+
+	for (int row = 0; row < n; row += BATCH_SIZE) {
+		int len = n - row < BATCH_SIZE ? n - row : BATCH_SIZE;
+		// variables are read in place from the columns
+		for (int i = 0; i < prog->numVar; i++)
+			rp[i] = (float*)cols[i] + row;
+		for (int k = 0; k < prog->numInstr; k++) {
+			const INSTR* in = &prog->code[k];
+			float* d = rp[in->dst];
+			const float* a = rp[in->src1];
+			const float* b = rp[in->src2];
+			int i = 0;
+			switch (in->op) {
+				case OP_ADD: BATCH_LOOP(+); break;
+				case OP_SUB: BATCH_LOOP(-); break;
+				case OP_MUL: BATCH_LOOP(*); break;
+				case OP_DIV: BATCH_LOOP(/); break;
+			}
+		}
+		memcpy(out + row, rp[prog->result], len * sizeof(float));
+	}
+	free(rp);
+	free(temp);
+	return 1;
+}
+
+/* prints the instructions of a program
+*/
+void printProgram(PROGRAM* prog) {
+	static const char opName[][4] = { "add", "sub", "mul", "div" };
+	for (int r = prog->numVar; r < prog->numVar + prog->numConst; r++)
+		printf("\tr%d = %g\n", r, prog->reg[r]);
+	for (int i = 0; i < prog->numInstr; i++)
+		printf("\t%s r%d, r%d, r%d\n", opName[prog->code[i].op], prog->code[i].dst, prog->code[i].src1, prog->code[i].src2);
+	printf("\treturn r%d\n", prog->result);
+}
+
+/* Deletes a program and recycles memory
+*/
+void destroyProgram(PROGRAM* prog) {
+	if (prog) {
+		free(prog->code);
+		free(prog->reg);
+	}
+	free(prog);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -213,7 +883,8 @@ void destroyTree( TREE *pTree)
 {
 	if (pTree)
 	{
-		_destroy( pTree->root);
+		free( pTree->node);
+		destroyVars( pTree->vars);
 	}
 		
 	free( pTree);
@@ -222,7 +893,7 @@ void destroyTree( TREE *pTree)
 ////////////////////////////////////////////////////////////////////////////////
 void printTree( TREE *pTree)
 {
-	_infix_print(pTree->root, 0);
+	_infix_print(pTree->node, pTree->root, 0, pTree->vars);
 	
 	return;
 }
@@ -230,16 +901,484 @@ void printTree( TREE *pTree)
 ////////////////////////////////////////////////////////////////////////////////
 void traverseTree( TREE *pTree)
 {
-	_traverse(pTree->root);
+	_traverse(pTree->node, pTree->root, pTree->vars);
 	
 	return;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+#define STREAM_BLOCK	(1 << 22)	// bytes read at once in streaming mode
+#define VALUE_BYTES		64			// upper bound of a printed value ("%f\n" of any float)
+#define BENCH_ROWS		256			// rows per expression in the batch benchmark
+
+// elapsed time in nanoseconds
+static long long elapsed_ns( const struct timespec *t0, const struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) * 1000000000LL + (t1->tv_nsec - t0->tv_nsec);
+}
+
+// splits buf (len bytes) into lines in place; empty lines are skipped and "\r\n" is accepted
+// return	number of lines (*line is grown as needed), -1 if overflow
+static int split_lines( char *buf, size_t len, char ***line, int *capacity)
+{
+	int num = 0;
+	char *p = buf, *end = buf + len;
+	
+	while (p < end)
+	{
+		char *eol = memchr( p, '\n', end - p);
+		if (eol == NULL)
+			eol = end;
+		*eol = '\0';
+		if (eol > p && eol[-1] == '\r')
+			eol[-1] = '\0';
+		if (*p != '\0')
+		{
+			if (num == *capacity)
+			{
+				int cap = *capacity ? *capacity * 2 : 1024;
+				char **grown = (char **)realloc( *line, cap * sizeof(char *));
+				if (grown == NULL)
+					return -1;
+				*line = grown;
+				*capacity = cap;
+			}
+			(*line)[num++] = p;
+		}
+		p = eol + 1;
+	}
+	return num;
+}
+
+// work of one streaming thread: values of line[first, last) printed into out
+typedef struct
+{
+	char	**line;
+	int		first;
+	int		last;
+	int		optimize;
+	VARS	*bindings;
+	char	*out;
+	size_t	outLen;
+	int		error;
+} tWorker;
+
+// evaluates the lines of a worker, reusing one tree (and its node array) for all of them
+static void *stream_worker( void *arg)
+{
+	tWorker *w = (tWorker *)arg;
+	TREE *tree = createTree();
+	float *values = NULL;
+	int numValues = 0;
+	
+	w->outLen = 0;
+	w->out = (char *)malloc( (size_t)(w->last - w->first) * VALUE_BYTES + 1);
+	w->error = (tree == NULL || w->out == NULL);
+	
+	for (int i = w->first; i < w->last && !w->error; i++)
+	{
+		if (!postfix2tree( w->line[i], tree))
+		{
+			w->outLen += sprintf( w->out + w->outLen, "invalid expression!\n");
+			continue;
+		}
+		if (w->optimize && !optimizeTree( tree))
+			w->error = 1;
+		if (tree->vars->count > numValues)
+		{
+			free( values);
+			numValues = tree->vars->count * 2;
+			values = (float *)malloc( numValues * sizeof(float));
+			if (values == NULL)
+			{
+				w->error = 1;
+				break;
+			}
+		}
+		bindTree( tree, w->bindings, values);
+		w->outLen += sprintf( w->out + w->outLen, "%f\n", evalTree( tree, values));
+	}
+	free( values);
+	destroyTree( tree);
+	return NULL;
+}
+
+// streaming mode: evaluates one expression per line of fp and prints only the values
+// the input is read in blocks of STREAM_BLOCK bytes; the lines of a block are shared by numThread threads
+// and the values are printed in input order
+// return	0 if successful, 1 if overflow
+int run_stream( FILE *fp, int numThread, int optimize, VARS *bindings)
+{
+	size_t capacity = STREAM_BLOCK, carry = 0;
+	char *buf = (char *)malloc( capacity + 1);
+	char **line = NULL;
+	int lineCapacity = 0;
+	pthread_t *tid = (pthread_t *)malloc( numThread * sizeof(pthread_t));
+	tWorker *w = (tWorker *)malloc( numThread * sizeof(tWorker));
+	int error = (buf == NULL || tid == NULL || w == NULL);
+	
+	while (!error)
+	{
+		size_t len = carry + fread( buf + carry, 1, capacity - carry, fp);
+		int eof = (len < capacity);
+		size_t used = len;
+		
+		// a block ends at its last newline; the partial line is carried to the next block
+		if (!eof)
+		{
+			while (used > 0 && buf[used - 1] != '\n')
+				used--;
+			if (used == 0)
+			{
+				// a line longer than the buffer
+				char *grown = (char *)realloc( buf, capacity * 2 + 1);
+				if (grown == NULL)
+				{
+					error = 1;
+					break;
+				}
+				buf = grown;
+				carry = capacity;
+				capacity *= 2;
+				continue;
+			}
+		}
+		
+		int num = split_lines( buf, used, &line, &lineCapacity);
+		if (num < 0)
+		{
+			error = 1;
+			break;
+		}
+		int per = (num + numThread - 1) / numThread;
+		for (int t = 0; t < numThread; t++)
+		{
+			w[t].line = line;
+			w[t].first = t * per < num ? t * per : num;
+			w[t].last = (t + 1) * per < num ? (t + 1) * per : num;
+			w[t].optimize = optimize;
+			w[t].bindings = bindings;
+			if (t > 0)
+				pthread_create( &tid[t], NULL, stream_worker, &w[t]);
+		}
+		stream_worker( &w[0]);
+		for (int t = 0; t < numThread; t++)
+		{
+			if (t > 0)
+				pthread_join( tid[t], NULL);
+			if (w[t].error)
+				error = 1;
+			else
+				fwrite( w[t].out, 1, w[t].outLen, stdout);
+			free( w[t].out);
+		}
+		
+		if (eof)
+			break;
+		carry = len - used;
+		memmove( buf, buf + used, carry);
+	}
+	free( buf);
+	free( line);
+	free( tid);
+	free( w);
+	if (error)
+		fprintf( stderr, "Out of memory\n");
+	return error;
+}
+
+// appends a random postfix expression of at most depth levels to buf
+// tokens are separated by ',' (numbers 0..99, decimals and variables x, y, z)
+// top is 1 for a whole expression, which is never a single number ("12" would read as two tokens)
+static int gen_expr( char *buf, int len, int depth, int top, unsigned int *seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	unsigned int r = *seed >> 16;
+	
+	if (depth == 0 || (r % 4 == 0 && !top))
+	{
+		if (r % 3 == 0)
+			return len + sprintf( buf + len, "%c,", "xyz"[(r >> 2) % 3]);
+		if (r % 5 == 0)
+			return len + sprintf( buf + len, "%d.%d,", (r >> 2) % 10, (r >> 6) % 10);
+		return len + sprintf( buf + len, "%u,", (r >> 2) % 100);
+	}
+	len = gen_expr( buf, len, depth - 1, 0, seed);
+	len = gen_expr( buf, len, depth - 1, 0, seed);
+	return len + sprintf( buf + len, "%c,", "+-*/"[(r >> 2) % 4]);
+}
+
+// generator mode: prints num random expressions, one per line
+void run_generate( int num)
+{
+	char buf[1 << 12];	// depth 6: at most 127 tokens of at most 5 bytes
+	unsigned int seed = 1;
+	
+	for (int i = 0; i < num; i++)
+	{
+		int len = gen_expr( buf, 0, 6, 1, &seed);
+		buf[len - 1] = '\n';	// last ','
+		fwrite( buf, 1, len, stdout);
+	}
+}
+
+// prints one benchmark result line
+// checksum is the sum of the finite values (so that no evaluation can be skipped)
+static void print_rate( const char *name, long long num, const char *unit, const struct timespec *t0, const struct timespec *t1, double checksum)
+{
+	double sec = elapsed_ns( t0, t1) / 1e9;
+	fprintf( stdout, "%-10s: %lld %s in %.3f s (%.0f %s/sec), checksum %g\n", name, num, unit, sec, sec > 0 ? num / sec : 0.0, unit, checksum);
+}
+
+// benchmark mode: reads all expressions of fp (one per line), then measures
+// parse only (postfix2tree), parse + eval (postfix2tree, evalTree), eval only (compiled programs)
+// and batch eval (each program over BENCH_ROWS rows)
+// return	0 if successful, 1 if overflow
+int run_bench( FILE *fp, int optimize, VARS *bindings)
+{
+	size_t capacity = STREAM_BLOCK, len = 0, got;
+	char *buf = (char *)malloc( capacity + 1);
+	char **line = NULL;
+	int lineCapacity = 0, num = 0, total = 0, valid = 0, maxVar = 1;
+	TREE *tree = createTree();
+	PROGRAM **prog = NULL;
+	float **values = NULL;
+	float *cols[26], *out = NULL;
+	struct timespec t0, t1;
+	double checksum;
+	int error = (buf == NULL || tree == NULL);
+	
+	// whole input in memory
+	while (!error && (got = fread( buf + len, 1, capacity - len, fp)) > 0)
+	{
+		len += got;
+		if (len == capacity)
+		{
+			char *grown = (char *)realloc( buf, capacity * 2 + 1);
+			error = (grown == NULL);
+			if (grown)
+			{
+				buf = grown;
+				capacity *= 2;
+			}
+		}
+	}
+	if (!error)
+	{
+		num = split_lines( buf, len, &line, &lineCapacity);
+		error = (num < 0);
+	}
+	if (!error)
+	{
+		total = num;
+		prog = (PROGRAM **)calloc( num + 1, sizeof(PROGRAM *));
+		values = (float **)calloc( num + 1, sizeof(float *));
+		out = (float *)malloc( BENCH_ROWS * sizeof(float));
+		error = (prog == NULL || values == NULL || out == NULL);
+	}
+	if (error)
+	{
+		fprintf( stderr, "Out of memory\n");
+		num = 0;
+	}
+	
+	// parse only
+	clock_gettime( CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < num; i++)
+		valid += postfix2tree( line[i], tree);
+	clock_gettime( CLOCK_MONOTONIC, &t1);
+	if (num > 0)
+	{
+		fprintf( stdout, "%d expressions (%d valid)\n", num, valid);
+		print_rate( "parse", num, "expressions", &t0, &t1, valid);
+	}
+	
+	// parse + eval (one tree reused)
+	float small[64];
+	checksum = 0;
+	clock_gettime( CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < num; i++)
+	{
+		if (postfix2tree( line[i], tree) && tree->vars->count <= 64 && (!optimize || optimizeTree( tree)))
+		{
+			bindTree( tree, bindings, small);
+			float v = evalTree( tree, small);
+			if (isfinite( v))
+				checksum += v;
+		}
+	}
+	clock_gettime( CLOCK_MONOTONIC, &t1);
+	if (num > 0)
+		print_rate( "parse+eval", num, "expressions", &t0, &t1, checksum);
+	
+	// programs and their bindings (not timed)
+	for (int i = 0; i < num && !error; i++)
+	{
+		if (!postfix2tree( line[i], tree) || (optimize && !optimizeTree( tree)))
+			continue;
+		prog[i] = compileTree( tree);
+		values[i] = (float *)malloc( (tree->vars->count + 1) * sizeof(float));
+		if (prog[i] == NULL || values[i] == NULL)
+			error = 1;
+		else
+			bindTree( tree, bindings, values[i]);
+		if (tree->vars->count > maxVar)
+			maxVar = tree->vars->count;
+	}
+	if (error)
+	{
+		fprintf( stderr, "Out of memory\n");
+		num = 0;
+	}
+	
+	// eval only
+	checksum = 0;
+	clock_gettime( CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < num; i++)
+	{
+		if (prog[i])
+		{
+			float v = runProgram( prog[i], values[i]);
+			if (isfinite( v))
+				checksum += v;
+		}
+	}
+	clock_gettime( CLOCK_MONOTONIC, &t1);
+	if (num > 0)
+		print_rate( "eval", valid, "expressions", &t0, &t1, checksum);
+	
+	// batch eval: every variable takes BENCH_ROWS values
+	int numCol = 0;
+	if (num > 0 && maxVar <= 26)
+	{
+		for (; numCol < maxVar; numCol++)
+		{
+			cols[numCol] = (float *)malloc( BENCH_ROWS * sizeof(float));
+			if (cols[numCol] == NULL)
+				break;
+			for (int r = 0; r < BENCH_ROWS; r++)
+				cols[numCol][r] = (numCol + 1) + r * 0.01f;
+		}
+	}
+	if (num > 0 && numCol == maxVar)
+	{
+		checksum = 0;
+		clock_gettime( CLOCK_MONOTONIC, &t0);
+		for (int i = 0; i < num; i++)
+		{
+			if (prog[i] && runProgramBatch( prog[i], (const float *const *)cols, BENCH_ROWS, out) && isfinite( out[0]))
+				checksum += out[0];
+		}
+		clock_gettime( CLOCK_MONOTONIC, &t1);
+		print_rate( "batch", (long long)valid * BENCH_ROWS, "rows", &t0, &t1, checksum);
+	}
+	
+	for (int c = 0; c < numCol; c++)
+		free( cols[c]);
+	for (int i = 0; prog && values && i < total; i++)
+	{
+		destroyProgram( prog[i]);
+		free( values[i]);
+	}
+	free( prog);
+	free( values);
+	free( out);
+	free( line);
+	free( buf);
+	destroyTree( tree);
+	return error;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 int main( int argc, char **argv)
 {
 	TREE *tree;
 	char expr[1024];
+	int bytecode = 0;
+	int optimize = 0;
+	int numThread = 1;
+	int generate = -1;
+	char *streamFile = NULL;
+	char *benchFile = NULL;
+	VARS *bindings = createVars();
+	
+	if (!bindings)
+	{
+		printf( "Cannot create bindings\n");
+		return 100;
+	}
+	
+	for (int i = 1; i < argc; i++)
+	{
+		char *eq;
+		
+		if (strcmp( argv[i], "-b") == 0)	// also compile to bytecode
+			bytecode = 1;
+		else if (strcmp( argv[i], "-O") == 0)	// optimize the tree
+			optimize = 1;
+		else if (strcmp( argv[i], "-s") == 0 && i + 1 < argc)	// streaming mode
+			streamFile = argv[++i];
+		else if (strcmp( argv[i], "-j") == 0 && i + 1 < argc && atoi( argv[i + 1]) > 0)
+			numThread = atoi( argv[++i]);
+		else if (strcmp( argv[i], "-g") == 0 && i + 1 < argc && atoi( argv[i + 1]) >= 0)	// generator mode
+			generate = atoi( argv[++i]);
+		else if (strcmp( argv[i], "-B") == 0 && i + 1 < argc)	// benchmark mode
+			benchFile = argv[++i];
+		else if (strcmp( argv[i], "-v") == 0 && i + 1 < argc && (eq = strchr( argv[i + 1], '=')) != NULL)
+		{
+			// variable binding (name=value)
+			if (setVar( bindings, argv[i + 1], (int)(eq - argv[i + 1]), strtof( eq + 1, NULL)) < 0)
+			{
+				printf( "Cannot bind variable\n");
+				return 100;
+			}
+			i++;
+		}
+		else
+		{
+			fprintf( stderr, "usage: %s [-b] [-O] [-v NAME=VALUE]...\n", argv[0]);
+			fprintf( stderr, "       %s -s FILE [-j THREADS] [-O] [-v NAME=VALUE]...\n", argv[0]);
+			fprintf( stderr, "       %s -g COUNT\n", argv[0]);
+			fprintf( stderr, "       %s -B FILE [-O] [-v NAME=VALUE]...\n", argv[0]);
+			fprintf( stderr, "\t-b : also print the bytecode and its value\n");
+			fprintf( stderr, "\t-O : fold constants and share common subexpressions before printing\n");
+			fprintf( stderr, "\t-v : value of a variable (tokens are separated by ',' when variables are used, ex) x,2.5,*)\n");
+			fprintf( stderr, "\t-s : print only the values of the expressions in FILE (one per line, - for stdin)\n");
+			fprintf( stderr, "\t-j : number of threads for -s\n");
+			fprintf( stderr, "\t-g : print COUNT random expressions\n");
+			fprintf( stderr, "\t-B : expressions/sec for parse, parse+eval, eval (bytecode) and batch eval of FILE\n");
+			destroyVars( bindings);
+			return 1;
+		}
+	}
+	
+	if (generate >= 0)
+	{
+		run_generate( generate);
+		destroyVars( bindings);
+		return 0;
+	}
+	if (streamFile || benchFile)
+	{
+		char *file = streamFile ? streamFile : benchFile;
+		FILE *fp = strcmp( file, "-") == 0 ? stdin : fopen( file, "r");
+		int ret;
+		
+		if (fp == NULL)
+		{
+			fprintf( stderr, "Error: cannot open file [%s]\n", file);
+			destroyVars( bindings);
+			return 2;
+		}
+		if (streamFile)
+			ret = run_stream( fp, numThread, optimize, bindings);
+		else
+			ret = run_bench( fp, optimize, bindings);
+		if (fp != stdin)
+			fclose( fp);
+		destroyVars( bindings);
+		return ret;
+	}
 	
 	fprintf( stdout, "\nInput an expression (postfix): ");
 	
@@ -264,6 +1403,14 @@ int main( int argc, char **argv)
 			continue;
 		}
 		
+		// constant folding, identities and common subexpressions
+		if (optimize)
+		{
+			int before = tree->count;
+			if (optimizeTree( tree))
+				fprintf( stdout, "\nNodes : %d -> %d\n", before, tree->count);
+		}
+		
 		// expression tree -> infix expression
 		fprintf( stdout, "\nInfix expression : ");
 		traverseTree( tree);
@@ -272,12 +1419,34 @@ int main( int argc, char **argv)
 		fprintf( stdout, "\n\nTree representation:\n");
 		printTree(tree);
 		// evaluate postfix expression
-		float val = evalPostfix( expr);
+		float val = evalPostfix( expr, bindings);
 		fprintf( stdout, "\nValue = %f\n", val);
+		
+		float *values = (float *)malloc( (tree->vars->count + 1) * sizeof(float));
+		if (values)
+			bindTree( tree, bindings, values);
+		
+		if (optimize && values)
+			fprintf( stdout, "\nValue (optimized) = %f\n", evalTree( tree, values));
+		
+		// expression tree -> bytecode
+		if (bytecode)
+		{
+			PROGRAM *prog = compileTree( tree);
+			if (prog && values)
+			{
+				fprintf( stdout, "\nBytecode:\n");
+				printProgram( prog);
+				fprintf( stdout, "\nValue (bytecode) = %f\n", runProgram( prog, values));
+			}
+			destroyProgram( prog);
+		}
+		free( values);
 		// destroy tree
 		destroyTree( tree);
 		
 		fprintf( stdout, "\nInput an expression (postfix): ");
 	}
+	destroyVars( bindings);
 	return 0;
 }